@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stddef.h>
+
+// The packed values are processed 4 at a time with SSE2 where it is available,
+// everywhere else one at a time. Arithmetic wraps around like the int
+// arithmetic of the interpreter does.
+#if defined(__SSE2__)
+#define MOD_ARRAY_SSE2 1
+#endif
+
+// Loops over the packed values of an Array, behind the builtins working on whole arrays
+int sumInts(const int *values, size_t n);
+int minInts(const int *values, size_t n); // n > 0
+int maxInts(const int *values, size_t n); // n > 0
+long findInt(const int *values, size_t n, int value); // position of the first equal value, -1 if none
+
+// out[i] = a[i] op b[i], out may be a or b
+void addInts(const int *a, const int *b, int *out, size_t n);
+void subInts(const int *a, const int *b, int *out, size_t n);
+void mulInts(const int *a, const int *b, int *out, size_t n);
@@ -3,9 +3,16 @@
 #include <string>
 #include <vector>
 #include <utility>
+#include <unordered_set>
 
 #include "token.hpp"
 
+struct CompiledNode;
+struct JitFunction;
+struct JitLoop;
+class Object;
+class Builtin;
+
 class Node
 {
 public:
@@ -58,6 +65,8 @@ class Identifier : public Expression
 public:
 	Token token;
 	std::string value;
+	Builtin *builtin = nullptr; // set by the Resolver when no binding can shadow the builtin of this name
+	int capture = -1;			// position in the captures of the function literal around it, for a captured variable it only reads
 
 	Identifier() {} // if parameterized constructor (below) is specified then this must be specified too
 	Identifier(Token token, std::string value)
@@ -87,17 +96,39 @@ public:
 	std::string nodeType() { return "LetStatement"; }
 };
 
+class InfixExpression;
+
 class AssignStatement : public Statement
 {
 public:
 	Token token; // token ASSIGN
 	Identifier name;
 	Expression *value;
+	std::string op; // operator of a compound assignment `x op= v`, whose value is `x op v`, empty otherwise
 
 	void statementNode() {}
 	std::string tokenLiteral() { return token.literal; }
 	std::string getStringRepr();
 	std::string nodeType() { return "AssignStatement"; }
+
+	// value of a compound assignment while it still is `name op v`, nullptr otherwise
+	InfixExpression *compound();
+};
+
+class IndexExpression;
+
+// `a[i] = v;`, sets an element of an array or deque or a hashmap value in place
+class IndexAssignStatement : public Statement
+{
+public:
+	Token token; // token ASSIGN
+	IndexExpression *target;
+	Expression *value;
+
+	void statementNode() {}
+	std::string tokenLiteral() { return token.literal; }
+	std::string getStringRepr();
+	std::string nodeType() { return "IndexAssignStatement"; }
 };
 
 class ReturnStatement : public Statement
@@ -129,6 +160,7 @@ class IntegerLiteral : public Expression
 public:
 	Token token;
 	int value;
+	Object *constant = nullptr; // Integer this evaluates to, set by the Optimizer
 
 	void expressionNode() {}
 	std::string tokenLiteral() { return token.literal; }
@@ -202,6 +234,12 @@ class BlockStatement : public Statement
 public:
 	Token token; // "{"
 	std::vector<Statement *> statements;
+	CompiledNode *compiled = nullptr; // set by ClosureCompiler for function bodies
+
+	// call counter and native code when used as a function body under the JIT
+	int hotness = 0;
+	JitFunction *jitted = nullptr;
+	bool jitFailed = false;
 
 	void statementNode() {}
 	std::string tokenLiteral() { return token.literal; }
@@ -232,6 +270,12 @@ public:
 	Expression *condition;
 	BlockStatement *consequence;
 
+	// back-edge counter and faster tier code for on-stack replacement
+	int hotness = 0;
+	JitLoop *jitted = nullptr;
+	bool jitFailed = false;
+	CompiledNode *compiled = nullptr;
+
 	void expressionNode() {}
 	std::string tokenLiteral() { return token.literal; }
 	std::string getStringRepr();
@@ -245,14 +289,30 @@ public:
 	std::vector<Identifier *> parameters;
 	BlockStatement *body;
 
+	// variables of enclosing functions the body (or a function inside it) uses,
+	// the only ones a closure created from this literal keeps
+	std::vector<std::string> captures;
+	bool capturesAnalyzed = false;
+
 	void expressionNode() {}
 	std::string tokenLiteral() { return token.literal; }
 	std::string getStringRepr();
 	std::string nodeType() { return "FunctionLiteral"; }
 
+	std::vector<std::string> &Captures();
+
 	TokenType getTokenType() { return token.type; }
 };
 
+#define CALL_CACHE_SIZE 4
+
+// Callee an inline cache has already checked to be callable from its call site
+struct CallCacheEntry
+{
+	Object *callee;
+	bool builtin;
+};
+
 class CallExpression : public Expression
 {
 public:
@@ -260,6 +320,10 @@ public:
 	Expression *function;
 	std::vector<Expression *> arguments;
 
+	// polymorphic inline cache of the callees seen here, filled by Evaluator::checkCallee
+	CallCacheEntry cache[CALL_CACHE_SIZE];
+	int cached = 0;
+
 	void expressionNode() {}
 
 	std::string tokenLiteral() { return token.literal; }
@@ -269,6 +333,26 @@ public:
 	TokenType getTokenType() { return token.type; }
 };
 
+// Call of a small function whose body the Optimizer substituted in. The
+// expression only stands for the call while call->function still names that
+// function, otherwise the call is made as written.
+class InlinedCall : public Expression
+{
+public:
+	CallExpression *call;
+	Expression *expression; // the function's body with the arguments in place of the parameters
+	BlockStatement *body;	// body of the inlined function, what the callee is checked against
+
+	Object *verified = nullptr; // last callee that passed the check
+
+	void expressionNode() {}
+	std::string tokenLiteral() { return call->tokenLiteral(); }
+	std::string getStringRepr();
+	std::string nodeType() { return "InlinedCall"; }
+
+	TokenType getTokenType() { return call->getTokenType(); }
+};
+
 class ArrayLiteral : public Expression
 {
 public:
@@ -306,6 +390,25 @@ public:
 	TokenType getTokenType() { return token.type; }
 };
 
+// `x[start:end]`, the part of a string or array from start up to but not
+// including end. start defaults to 0, a missing end (nullptr) to the length.
+class SliceExpression : public Expression
+{
+public:
+	Token token; // token [
+	Expression *array;
+	Expression *start;
+	Expression *end;
+
+	void expressionNode() {}
+
+	std::string tokenLiteral() { return token.literal; }
+	std::string getStringRepr();
+	std::string nodeType() { return "SliceExpression"; }
+
+	TokenType getTokenType() { return token.type; }
+};
+
 struct HashMapPair
 {
 	Expression *key;
@@ -417,4 +520,11 @@ public:
 	std::string nodeType() { return "MinHeapLiteral"; }
 
 	TokenType getTokenType() { return token.type; }
-};
\ No newline at end of file
+};
+
+// direct sub-nodes in evaluation order, a function literal's body included
+std::vector<Node *> childNodes(Node *node);
+
+// names the lets below node bind, not descending into function literals
+void declaredNames(Node *node, std::unordered_set<std::string> &names);
+
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "../header/ast.hpp"
+#include "../header/object.hpp"
+#include "../header/environment.hpp"
+#include "../header/evaluator.hpp"
+
+class ClosureCompiler;
+struct CompiledNode;
+
+// Handler bound to a compiled node, called directly instead of dispatching on nodeType()
+typedef Object *(*CompiledFn)(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+// Integer fast path of an infix operator, returns nullptr to defer to the generic path
+typedef Object *(*IntegerOpFn)(int left, int right);
+
+struct CompiledNode
+{
+	CompiledFn fn;
+	std::vector<CompiledNode *> children;
+
+	// pre-bound operands, which ones are used depends on fn
+	std::string name;
+	std::string operand;
+	int intValue = 0;
+	bool boolValue = false;
+	IntegerOpFn intOp = nullptr;
+	Node *node = nullptr;
+
+	Object *run(ClosureCompiler *cc, Environment *env) { return fn(cc, this, env); }
+};
+
+// Compiles a Program once into a tree of pre-bound handlers (closure compilation tier)
+class ClosureCompiler
+{
+	friend class Evaluator;
+
+private:
+	Evaluator evaluator; // shared operator and builtin semantics
+
+	CompiledNode *compile(Node *node);
+	CompiledNode *compileBody(BlockStatement *body);
+	CompiledNode *newNode(CompiledFn fn, Node *node);
+
+	Object *call(CompiledNode *node, Environment *env, bool tail);
+	Object *callFunction(Function *function, std::vector<Object *> &args);
+
+	int callDepth = 0; // as in Evaluator, returns only become tail calls inside a function
+	bool returning = false; // as in Evaluator, no wrapper object for returned values
+	TailCall tailCall;
+
+	static Object *runProgram(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runBlock(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runExpressionStatement(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runReturn(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runLet(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runAssign(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runCompoundAssign(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runIndexAssign(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+
+	static Object *runIntegerLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runBooleanLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runStringLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runNull(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+
+	static Object *runPrefix(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runInfix(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+
+	static Object *runIf(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runWhile(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runIdentifier(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runFunctionLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runCall(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runInlinedCall(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+
+	static Object *runArrayLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runIndex(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runSlice(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runHashMapLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runHashSetLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runStackLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runQueueLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runDequeLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runMaxHeapLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+	static Object *runMinHeapLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env);
+
+public:
+	CompiledNode *Compile(Node *node);
+	Object *Run(CompiledNode *code, Environment *env);
+};
@@ -2,16 +2,50 @@
 
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 #include "./object.hpp"
 
+#define ENV_INLINE_BINDINGS 4 // most calls bind 1 to 4 names, parameters and lets
+
+// Bindings of one scope. Most scopes hold a handful of names, so they are kept
+// in inline arrays and searched linearly; a scope that outgrows them moves to
+// a hash table.
+class Bindings
+{
+private:
+	std::string names[ENV_INLINE_BINDINGS];
+	Object *values[ENV_INLINE_BINDINGS];
+	int count = 0;
+
+	std::unordered_map<std::string, Object *> *table = nullptr;
+
+public:
+	Bindings() {}
+	~Bindings() { delete table; }
+
+	// the table is owned, copies would free it twice
+	Bindings(const Bindings &) = delete;
+	Bindings &operator=(const Bindings &) = delete;
+
+	Object **find(const std::string &name); // slot of name, nullptr if it is not bound here
+	void add(const std::string &name, Object *value); // name must not be bound here yet
+	void clear();
+
+	size_t size();
+	std::vector<std::string> keys();
+};
+
 class Environment {
 public:
-	std::unordered_map<std::string, Object*> store;
-	Environment *outer;
+	Bindings store;
+	Environment *outer = nullptr;
+	std::vector<Cell *> cells; // of a closure, its captured variables in the order of its literal's captures
 	
 	Environment* New();
 	Environment* NewEnclosed();
 	Object* Get(std::string name);
+	Object* Lookup(const std::string &name); // nullptr if name is not bound
 	Object* Set(std::string name, Object* val);
-};
\ No newline at end of file
+	Cell* Capture(const std::string &name, Environment *root);
+};
@@ -3,9 +3,28 @@
 #include "../header/ast.hpp"
 #include "../header/object.hpp"
 #include "../header/environment.hpp"
+#include "../header/jit.hpp"
+
+class ClosureCompiler;
+
+bool isTruthy(Object *condition);
+
+// `return f(x);` inside a function: the callee and its evaluated arguments are
+// handed back to the calling trampoline, which runs the call in place of the
+// returning frame instead of nesting it. Each tier keeps one and refills it.
+struct TailCall
+{
+	CallExpression *call = nullptr;
+	Function *function = nullptr; // set while a tail call is pending
+	std::vector<Object *> args;
+};
 
 class Evaluator
 {
+	friend class ClosureCompiler;
+	friend class StackEvaluator;
+	friend class Optimizer;
+
 private:
 	Object *evalProgram(Program *program, Environment *env);
 	Object *evalBlockStatement(BlockStatement *blockStmt, Environment *env);
@@ -19,13 +38,22 @@ private:
 	Object *evalStringInfixExpression(std::string operand, Object *left, Object *right);
 
 	Object *evalIfExpression(IfExpression *ifExpr, Environment *env);
+	Object *evalWhileExpression(WhileExpression *whileExpr, Environment *env);
+	Object *evalOsr(WhileExpression *whileExpr, Environment *env);
 	Object *evalIdentifier(Identifier *ident, Environment *env);
-	Object *evalCallExpression(Object *fn, std::vector<Object *> &args);
+	Object *evalCall(CallExpression *call, Environment *env, bool tail);
+	Object *checkCallee(CallExpression *call, Object *fn, bool &builtin);
+	bool inlineHolds(InlinedCall *inlined, Environment *env);
+	Object *applyFunction(Function *fn, std::vector<Object *> &args);
+	Object *evalJitCall(CallExpression *call, Function *fn, std::vector<Object *> &args);
 
 	Object *evalIndexExpression(Object *left, Object *index, Environment *env);
 	Object *evalStringIndexExpression(String *string, Integer *index);
 	Object *evalArrayIndexExpression(Array *array, Integer *index);
 	Object *evalHashMapIndexExpression(HashMap *hashMap, Object *index);
+	Object *evalSliceExpression(Object *left, Object *start, Object *end);
+	Object *evalIndexAssignment(Object *left, Object *index, Object *value);
+	Object *evalCompoundAssignment(const std::string &name, const std::string &op, Object *right, Environment *env);
 
 	Object *evalHashMapLiteral(HashMapLiteral *hashMapLiteral, Environment *env);
 	Object *evalHashSetLiteral(HashSetLiteral *hashSetLiteral, Environment *env);
@@ -35,8 +63,29 @@ private:
 	Object *evalMaxHeapLiteral(MaxHeapLiteral *maxHeapLiteral, Environment *env);
 	Object *evalMinHeapLiteral(MinHeapLiteral *minHeapLiteral, Environment *env);
 
+	Object *makeClosure(FunctionLiteral *literal, Environment *env);
 	Environment *extendFunctionEnv(Function *fn, std::vector<Object *> &args, Environment *outer);
+	Environment *reuseFunctionEnv(Function *fn, std::vector<Object *> &args, Environment *frame);
+	void releaseFunctionEnv(Environment *frame);
+
+	std::vector<Environment *> framePool; // frames of finished calls, ready for the next ones
+
+	int callDepth = 0; // mod function calls in progress, returns only become tail calls inside one
+
+	// Set by a return statement while its value is handed up to the enclosing
+	// function or program, which clears it. Blocks and loops stop early while
+	// it is set, no wrapper object is allocated for the returned value.
+	bool returning = false;
+	TailCall tailCall;
+
+	Jit *jit = nullptr;
+
+	int osrThreshold = 0; // loop back-edges before on-stack replacement, 0 disables it
+	ClosureCompiler *osrCompiler = nullptr;
 
 public:
+	void EnableJit(Jit *jit) { this->jit = jit; }
+	void EnableOsr(int threshold = 1000);
+
 	Object *Eval(Node *node, Environment *env);
 };
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+// Control bytes are matched 16 at a time with SSE2 where it is available,
+// everywhere else the same masks are built one byte at a time.
+#if defined(__SSE2__)
+#define MOD_HASH_TABLE_SSE2 1
+#endif
+
+#define HASH_TABLE_GROUP 16
+#define HASH_TABLE_MIN_CAPACITY 16
+#define HASH_TABLE_EMPTY ((int8_t)-128) // control byte of an empty slot, full slots are 0..127
+#define HASH_TABLE_NOT_FOUND ((size_t)-1)
+#define HASH_TABLE_SMALL_SIZE 8 // entries searched linearly before an index is built
+
+// How a HashTable finds its entries, picked from the keys it holds
+enum HashTableMode
+{
+	HASH_TABLE_SMALL,  // no index, the few entries are compared one by one
+	HASH_TABLE_DENSE,  // only small non-negative integer keys, indexed directly by their value
+	HASH_TABLE_HASHED, // open addressing index over the hashes
+};
+
+class Object;
+struct HashKey;
+
+// One entry of a hashmap or hashset
+struct HashEntry
+{
+	Object *key;   // nullptr once the entry was erased, until the entries are compacted
+	Object *value; // the key again in a hashset
+	size_t hash;   // mixed hash of the key, kept for rebuilding the index without rehashing
+};
+
+// Table behind HashMap and HashSet, laid out like a compact dict: the entries
+// sit in a dense array in insertion order, which is also the order they are
+// iterated in, and a separate index maps keys to them. The index depends on
+// the keys: none while there are at most HASH_TABLE_SMALL_SIZE entries, a
+// vector indexed by the key while all keys are integers from 0 up to about
+// twice the number of entries, and a hash index otherwise. Tables move to the
+// next mode as keys are added and never back.
+//
+// Every slot of the hash index has a control byte, either HASH_TABLE_EMPTY or
+// the low 7 bits of its entry's hash, so a probe compares a whole group of 16
+// slots against the hash with a single SSE2 compare and only follows slots
+// whose control byte matched. Probing is linear from the slot the hash
+// selects, and erase shifts the following slots back into the hole instead of
+// leaving a tombstone, so a probe stops at the first empty slot however many
+// entries were removed. Erased entries leave a hole in the dense array until
+// the next rebuild of the index compacts it.
+class HashTable
+{
+private:
+	HashTableMode mode = HASH_TABLE_SMALL;
+	std::vector<HashEntry> entries;
+	size_t count = 0;
+
+	std::vector<uint32_t> direct; // HASH_TABLE_DENSE: position in entries + 1 of each key, 0 if absent
+
+	std::vector<int8_t> ctrl;	 // HASH_TABLE_HASHED: capacity + HASH_TABLE_GROUP bytes, the last group mirrors the first
+	std::vector<uint32_t> slots; // position in entries of each full slot
+	size_t mask = 0;			 // capacity - 1, capacity is a power of two
+
+	static size_t mix(size_t hash);
+	static uint32_t matchByte(const int8_t *group, int8_t byte);
+	static uint32_t matchEmpty(const int8_t *group);
+	static bool denseKey(const HashKey &key, size_t count);
+	static Object *storedKey(Object *keyObj);
+
+	size_t capacity() const { return slots.size(); }
+	void setSlot(size_t slot, int8_t byte, uint32_t entry);
+	size_t lookup(const HashKey &key, size_t hash); // slot of the key in the hash index, HASH_TABLE_NOT_FOUND if absent
+	size_t position(const HashKey &key, size_t hash); // position of the key in entries, HASH_TABLE_NOT_FOUND if absent
+	void add(const HashKey &key, Object *keyObj, Object *value, size_t hash);
+	void place(uint32_t entry);
+	void compact();
+	void rebuild(HashTableMode newMode, size_t newCapacity);
+
+public:
+	class iterator
+	{
+	private:
+		HashTable *table;
+		size_t entry;
+
+		void skipErased();
+
+	public:
+		iterator(HashTable *table, size_t entry) : table(table), entry(entry) { skipErased(); }
+
+		HashEntry &operator*() { return table->entries[entry]; }
+		HashEntry *operator->() { return &table->entries[entry]; }
+		iterator &operator++();
+		bool operator!=(const iterator &other) const { return entry != other.entry; }
+	};
+
+	HashTableMode Mode() const { return mode; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	// nullptr if the key is not in the table, valid until the next insertion
+	HashEntry *find(const HashKey &key);
+	// adds the entry unless the key is already there, returns whether it was added
+	bool insert(const HashKey &key, Object *keyObj, Object *value);
+	// adds the entry or replaces the one with an equal key, which keeps its place in the order
+	void set(const HashKey &key, Object *keyObj, Object *value);
+	// returns whether the key was there
+	bool erase(const HashKey &key);
+
+	// in insertion order
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, entries.size()); }
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include "../header/ast.hpp"
+#include "../header/object.hpp"
+#include "../header/environment.hpp"
+
+// Native code generation is only available for x86-64 Linux, everywhere else
+// Jit::Compile() always declines and the interpreter runs the function instead.
+#if defined(__linux__) && defined(__x86_64__)
+#define MOD_JIT_SUPPORTED 1
+#endif
+
+enum JitType
+{
+	JIT_NONE, // not representable natively
+	JIT_INT,
+	JIT_BOOL,
+	JIT_ARRAY,	   // array of ints, passed as (elements data, length)
+	JIT_INT_ARRAY, // packed array, passed as (int values data, length)
+};
+
+// both kinds of array take two words and are only read
+inline bool isJitArray(JitType type)
+{
+	return type == JIT_ARRAY || type == JIT_INT_ARRAY;
+}
+
+typedef int (*JitEntryFn)(int64_t *args, int64_t *result);
+
+// Call the Optimizer inlined into compiled code, valid while the name still
+// refers to a closure of the inlined body
+struct JitInline
+{
+	std::string name;
+	BlockStatement *body;
+};
+
+// Native code of one mod function, specialised for the argument types seen when it got hot
+struct JitFunction
+{
+	JitEntryFn entry;
+	void *code;
+	size_t size;
+
+	std::vector<JitType> paramTypes;
+	int argWords; // int64 slots needed to pass the arguments
+	JitType returnType;
+
+	std::string selfName; // name recursive calls go through, guarded on entry
+	bool usesSelf;
+	std::vector<JitInline> inlines; // guarded on entry
+};
+
+// Native code of a hot loop entered through on-stack replacement, specialised
+// to the types its variables had in the Environment at that point
+struct JitLoop
+{
+	JitEntryFn entry;
+	void *code;
+	size_t size;
+
+	std::vector<std::string> names;
+	std::vector<JitType> types;
+	std::vector<bool> written;
+	int words; // int64 slots for the working values, as many again for the committed copy
+	std::vector<JitInline> inlines; // guarded on entry
+};
+
+enum JitLoopStatus
+{
+	JIT_LOOP_GUARD_FAILED, // variable types changed, the loop did not run
+	JIT_LOOP_DONE,		   // ran to completion
+	JIT_LOOP_BAILED,	   // stopped at a loop header, the interpreter has to finish it
+};
+
+// Baseline template JIT. Functions whose bodies only use integer / boolean
+// locals, arithmetic, comparisons, if, while, return, len(), indexing of
+// int arrays and calls the Optimizer inlined are compiled to x86-64 once they cross a call count threshold.
+// Any guard failure (division by zero, non int element, out of range index,
+// native recursion too deep) bails out and the call is re-run by the
+// interpreter, which is safe because compiled code has no side effects.
+class Jit
+{
+private:
+	int hotThreshold;
+
+public:
+	Jit(int hotThreshold = 1000) : hotThreshold(hotThreshold) {}
+
+	static bool Supported();
+	int HotThreshold() { return hotThreshold; }
+
+	// nullptr if the function is outside the compilable subset
+	JitFunction *Compile(Function *fn, std::string selfName, std::vector<Object *> &args);
+
+	// nullptr if a guard failed or the native code bailed out
+	Object *Call(JitFunction *code, Function *fn, std::vector<Object *> &args);
+
+	// on-stack replacement of a running while loop, variables are read from
+	// and written back to env
+	JitLoop *CompileLoop(WhileExpression *loop, Environment *env);
+	JitLoopStatus RunLoop(JitLoop *loop, Environment *env);
+};
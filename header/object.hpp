@@ -6,8 +6,10 @@
 #include <stack>
 #include <queue>
 #include <deque>
+#include <memory>
 
 #include "ast.hpp"
+#include "hash_table.hpp"
 
 typedef std::string ObjectType;
 
@@ -26,32 +28,22 @@ const ObjectType DEQUE_OBJ = "DEQUE";
 const ObjectType MAXHEAP_OBJ = "MAXHEAP";
 const ObjectType MINHEAP_OBJ = "MINHEAP";
 
-const ObjectType RETURN_VALUE_OBJ = "RETURN_VALUE";
 const ObjectType BUILTIN_OBJ = "BUILTIN";
 const ObjectType NULL_OBJ = "NULL";
 const ObjectType ERROR_OBJ = "ERROR";
+const ObjectType CELL_OBJ = "CELL";
 
 class Object
 {
 public:
 	virtual ObjectType type() = 0;
 	virtual std::string inspect() = 0;
-};
-
-// std::unordered_set<ObjectType> Hashable{INTEGER_OBJ, BOOLEAN_OBJ,STRING_OBJ};
-
-struct HashKey
-{
-	ObjectType type;
-	std::string value;
 
-	HashKey() {}
-	HashKey(ObjectType type, std::string value) : type{type}, value{value} {}
-
-	bool operator==(const HashKey &otherKey) const
-	{
-		return otherKey.type == type && otherKey.value == value;
-	}
+	// checked on nearly every evaluated value, so no ObjectType string is built or compared
+	virtual bool isError() { return false; }
+	virtual bool isCell() { return false; }
+	virtual bool isString() { return false; }
+	virtual bool isInteger() { return false; }
 };
 
 class Integer : public Object
@@ -62,6 +54,7 @@ public:
 	Integer(int v) : Object(), value(v) {}
 	ObjectType type() { return INTEGER_OBJ; }
 	std::string inspect() { return std::to_string(value); }
+	bool isInteger() { return true; }
 };
 
 class Boolean : public Object
@@ -74,24 +67,195 @@ public:
 	std::string inspect() { return value ? "true" : "false"; }
 };
 
+#define STRING_SHARE_MIN 64 // concatenations and slices shorter than this are copied right away
+
+// Text of a String: flat, the concatenation of two other nodes, or a view of
+// length characters of another, flat, node from offset. Concatenations and
+// views are only flattened, once, when the text itself is needed. A node that
+// is part of a concatenation or viewed never changes again, the String it
+// belongs to copies it before changing its text.
+struct StringNode
+{
+	std::string text;		  // valid once flat()
+	StringNode *left, *right; // parts of a concatenation that was not flattened yet
+	StringNode *base;		  // node a view was taken of
+	size_t offset;
+	size_t length;
+	bool shared = false; // part of a concatenation or viewed
+
+	StringNode(std::string text) : text(text), left(nullptr), right(nullptr), base(nullptr), offset(0), length(this->text.size()) {}
+	StringNode(StringNode *left, StringNode *right)
+		: left(left), right(right), base(nullptr), offset(0), length(left->length + right->length) {}
+	StringNode(StringNode *base, size_t offset, size_t length)
+		: left(nullptr), right(nullptr), base(base), offset(offset), length(length) {}
+
+	bool flat() { return left == nullptr && base == nullptr; }
+	void flatten();
+
+	// the characters, a view reads them from its base without a copy
+	const char *data()
+	{
+		if (base != nullptr)
+			return base->text.data() + offset;
+
+		flatten();
+		return text.data();
+	}
+};
+
+// A chain of + builds a tree of StringNodes instead of copying everything on
+// the left once per +, so building a string of total length n takes O(n)
+// however many pieces it has, and a slice shares the text it was taken from.
+// Hashing, printing and comparing read the flattened text through value(),
+// len() and indexing don't flatten.
 class String : public Object
 {
 public:
-	std::string value;
-
-	String(std::string s) : Object(), value{s} {}
+	// Made by `+=` and bound to nothing but the variable it was assigned to,
+	// the next `+=` on that variable appends in place. Reading the variable
+	// clears it, the string may be bound elsewhere from then on.
+	bool unique = false;
+
+	// the first node is part of the String, strings are allocated once
+	String(std::string s) : Object(), own(s), node(&own) {}
+	String(String *left, String *right); // left + right
+	String(String *string, size_t start, size_t end); // string[start:end]
+	String(String *string); // another String with the same text, shared until either changes
 	ObjectType type() { return STRING_OBJ; }
-	std::string inspect() { return value; }
+	std::string inspect() { return value(); }
+	bool isString() { return true; }
+
+	const std::string &value()
+	{
+		node->flatten();
+		return node->text;
+	}
+
+	size_t length() { return node->length; }
+	char at(size_t i) { return node->data()[i]; }
+
+	// std::string grows its buffer geometrically, repeated appends are amortized O(1)
+	void append(const std::string &s);
+	// false if the string is empty
+	bool popBack();
+
+	// computed on first use as a hash key and kept until the text changes
+	size_t hash()
+	{
+		if (!hashed)
+		{
+			hashValue = std::hash<std::string>()(value());
+			hashed = true;
+		}
+
+		return hashValue;
+	}
+
+private:
+	StringNode own;
+	StringNode *node;
+	size_t hashValue = 0;
+	bool hashed = false;
+
+	std::string &mutableText();
+};
+
+enum HashKeyKind
+{
+	HASH_KEY_INTEGER,
+	HASH_KEY_BOOLEAN,
+	HASH_KEY_STRING,
+	HASH_KEY_OTHER, // compared by type and inspect() text
+};
+
+// Key of a hashmap or hashset entry. Integers, booleans and strings hash and
+// compare by value without being converted to text, a string key refers to
+// the String it was made from, which a table copies when it stores the key.
+// Any other object falls back to its inspect().
+struct HashKey
+{
+	HashKeyKind kind;
+	size_t hash;
+	int number = 0;			   // integer value, or 1 / 0 for booleans
+	String *string = nullptr;  // HASH_KEY_STRING
+	ObjectType type;		   // HASH_KEY_OTHER
+	std::string value;		   // HASH_KEY_OTHER
+
+	HashKey() {}
+
+	HashKey(Object *obj)
+	{
+		if (obj->isInteger())
+		{
+			kind = HASH_KEY_INTEGER;
+			number = ((Integer *)obj)->value;
+			hash = std::hash<int>()(number);
+		}
+		else if (obj->isString())
+		{
+			kind = HASH_KEY_STRING;
+			string = (String *)obj;
+			hash = string->hash();
+		}
+		else if (obj->type() == BOOLEAN_OBJ)
+		{
+			kind = HASH_KEY_BOOLEAN;
+			number = ((Boolean *)obj)->value;
+			hash = number;
+		}
+		else
+		{
+			kind = HASH_KEY_OTHER;
+			type = obj->type();
+			value = obj->inspect();
+			hash = std::hash<std::string>()(type) ^ std::hash<std::string>()(value);
+		}
+	}
+
+	// whether obj, the key of an entry with the same hash, is equal to this key
+	bool matches(Object *obj) const
+	{
+		switch (kind)
+		{
+		case HASH_KEY_INTEGER:
+			return obj->isInteger() && ((Integer *)obj)->value == number;
+		case HASH_KEY_BOOLEAN:
+			return obj->type() == BOOLEAN_OBJ && ((Boolean *)obj)->value == number;
+		case HASH_KEY_STRING:
+			return obj == string || (obj->isString() && ((String *)obj)->value() == string->value());
+		default:
+			return obj->type() == type && obj->inspect() == value;
+		}
+	}
+};
+
+// What went wrong, with just the pieces needed to describe it. The message is
+// only formatted when an error is reported through inspect().
+enum ErrorCode
+{
+	ERROR_MESSAGE,				// detail is the whole message
+	ERROR_IDENTIFIER_NOT_FOUND, // detail is the name
+	ERROR_NOT_A_FUNCTION,		// detail is the type called
+	ERROR_ARGUMENT_LENGTH,		// got arguments, want parameters
+	ERROR_INDEX_OUT_OF_RANGE,	// got is the index
+	ERROR_SLICE_OUT_OF_RANGE,	// got is the start, want the end
 };
 
 class Error : public Object
 {
 public:
-	std::string value;
-
-	Error(std::string s) : Object(), value(s) {}
-	ObjectType type() { return ERROR_OBJ + " "; }
-	std::string inspect() { return value; }
+	ErrorCode code;
+	std::string detail;
+	int got = 0;
+	int want = 0;
+
+	Error(std::string s) : Object(), code(ERROR_MESSAGE), detail(s) {}
+	Error(ErrorCode c, std::string d) : Object(), code(c), detail(d) {}
+	Error(ErrorCode c, int got, int want = 0) : Object(), code(c), got(got), want(want) {}
+
+	ObjectType type() { return ERROR_OBJ; }
+	std::string inspect();
+	bool isError() { return true; }
 };
 
 class Null : public Object
@@ -101,26 +265,50 @@ public:
 	std::string inspect() { return "NULL"; }
 };
 
-class ReturnValue : public Object
+// Arguments of a builtin call, a view of wherever the caller keeps them
+class Arguments
 {
 public:
-	Object *value;
+	Object **data;
+	size_t count;
+
+	Arguments(Object **data, size_t count) : data(data), count(count) {}
 
-	ReturnValue(Object *v) : Object(), value(v) {}
-	ObjectType type() { return RETURN_VALUE_OBJ; }
-	std::string inspect() { return value->inspect(); }
+	Object *operator[](size_t i) { return data[i]; }
+	size_t size() { return count; }
+	Object **begin() { return data; }
+	Object **end() { return data + count; }
 };
 
+#define BUILTIN_VARIADIC -1
+#define BUILTIN_MAX_ARGS 4 // calls with up to this many arguments keep them on the native stack
+
 class Builtin : public Object
 {
 public:
-	Object *(*function)(std::vector<Object *> &);
+	Object *(*function)(Arguments);
+	int arity; // BUILTIN_VARIADIC if the builtin checks its argument count itself
 
-	Builtin(Object *(*fn)(std::vector<Object *> &)) : Object(), function(fn) {}
+	Builtin(Object *(*fn)(Arguments), int arity) : Object(), function(fn), arity(arity) {}
 	ObjectType type() { return BUILTIN_OBJ; }
 	std::string inspect() { return "Builtin Function"; }
 };
 
+// Box of a variable captured by a closure, shared by the frame that binds the
+// variable and the closures that use it. Environment reads and writes through
+// it, so it never shows up as a value. value stays nullptr while the captured
+// name is not bound yet.
+class Cell : public Object
+{
+public:
+	Object *value;
+
+	Cell(Object *value) : Object(), value(value) {}
+	ObjectType type() { return CELL_OBJ; }
+	std::string inspect() { return value == nullptr ? "null" : value->inspect(); }
+	bool isCell() { return true; }
+};
+
 class Environment;
 
 class Function : public Object
@@ -160,23 +348,44 @@ public:
 	}
 };
 
+// While every element is an Integer the values are packed into a vector of
+// ints, no Integer object per element, and read back boxed by at(). Each
+// element is boxed once, on its first read, and the box is kept with the
+// array until the element changes, so indexing a packed array in a loop
+// allocates no more than indexing an unpacked one. The first element of
+// another type stored unpacks the array into a vector of objects for good.
+// The builtins working on whole arrays run over the packed values directly.
+//
+// Either vector is shared by a slice with the array it was taken from, the
+// slice being a range of it. Whichever of them changes its elements first
+// copies them.
 class Array : public Object
 {
 public:
-	std::vector<Object *> elements;
-
-	Array(std::vector<Object *> &elems) : Object(), elements(elems) {}
+	Array(std::vector<Object *> &elems);
+	Array(std::vector<int> &values) : Object(), ints(std::make_shared<std::vector<int>>(values)) {}
+	Array(Array *array, size_t start, size_t end); // array[start:end]
 
 	ObjectType type() { return ARRAY_OBJ; }
 
+	bool isPacked() { return packed; }
+	const int *intData() { return ints->data() + offset; } // while packed
+	Object **data() { return items->data() + offset; }	   // while not packed
+	size_t size() { return view ? count : packed ? ints->size() : items->size(); }
+
+	Object *at(size_t i) { return packed ? boxed(i) : data()[i]; }
+	void set(size_t i, Object *value);
+	void push(Object *value);
+	void pop();
+
 	std::string inspect()
 	{
 		std::string res = "[";
 
-		for (auto elem : elements)
-			res += elem->inspect() + ", ";
+		for (size_t i = 0; i < size(); i++)
+			res += (packed ? std::to_string(intData()[i]) : data()[i]->inspect()) + ", ";
 
-		if (elements.size() != 0)
+		if (size() != 0)
 		{
 			res.pop_back();
 			res.pop_back();
@@ -186,31 +395,26 @@ public:
 
 		return res;
 	}
-};
 
-class HashMapPairObj
-{ // we could use std::pair but this is more explicit
-public:
-	Object *key;
-	Object *value;
+private:
+	std::shared_ptr<std::vector<int>> ints;		  // while packed
+	std::shared_ptr<std::vector<Object *>> items; // otherwise
+	bool packed = true;
+	bool view = false; // a range of the vector from offset, count long
+	size_t offset = 0;
+	size_t count = 0;
 
-	HashMapPairObj() {}
-	HashMapPairObj(Object *key, Object *value) : key{key}, value{value} {}
-};
+	std::vector<Object *> boxes; // while packed, an Integer for each element read so far, or empty
 
-struct HashFn
-{
-	size_t operator()(const HashKey &hashKey) const
-	{
-		return std::hash<std::string>()(hashKey.type) ^
-			   std::hash<std::string>()(hashKey.value);
-	}
+	Object *boxed(size_t i);
+	void unshare();
+	void unpack();
 };
 
 class HashMap : public Object
 {
 public:
-	std::unordered_map<HashKey, HashMapPairObj, HashFn> pairs;
+	HashTable pairs;
 
 	ObjectType type() { return HASHMAP_OBJ; }
 
@@ -218,8 +422,8 @@ public:
 	{
 		std::string res = "{";
 
-		for (auto pair : pairs)
-			res += pair.second.key->inspect() + " : " + pair.second.value->inspect() + ", ";
+		for (HashEntry &entry : pairs)
+			res += entry.key->inspect() + " : " + entry.value->inspect() + ", ";
 
 		if (pairs.size() != 0)
 		{
@@ -236,7 +440,7 @@ public:
 class HashSet : public Object
 {
 public:
-	std::unordered_map<HashKey, Object *, HashFn> pairs;
+	HashTable pairs;
 
 	ObjectType type() { return HASHSET_OBJ; }
 
@@ -244,8 +448,8 @@ public:
 	{
 		std::string res = "hashset<> {";
 
-		for (auto pair : pairs)
-			res += pair.second->inspect() + ", ";
+		for (HashEntry &entry : pairs)
+			res += entry.key->inspect() + ", ";
 
 		if (pairs.size() != 0)
 		{
@@ -317,10 +521,10 @@ struct MaxHeapCompareFn
 {
 	bool operator()(Object *obj1, Object *obj2)
 	{
-		if (obj1->type() == INTEGER_OBJ)
+		if (obj1->isInteger())
 			return ((Integer *)obj1)->value < ((Integer *)obj2)->value;
-		else if (obj1->type() == STRING_OBJ)
-			return ((String *)obj1)->value < ((String *)obj2)->value;
+		else if (obj1->isString())
+			return ((String *)obj1)->value() < ((String *)obj2)->value();
 		
 		return true;
 	}
@@ -355,10 +559,10 @@ struct MinHeapCompareFn
 {
 	bool operator()(Object *obj1, Object *obj2)
 	{
-		if (obj1->type() == INTEGER_OBJ)
+		if (obj1->isInteger())
 			return ((Integer *)obj1)->value > ((Integer *)obj2)->value;
 		else
-			return ((String *)obj1)->value > ((String *)obj2)->value;
+			return ((String *)obj1)->value() > ((String *)obj2)->value();
 	}
 };
 
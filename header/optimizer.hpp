@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../header/ast.hpp"
+#include "../header/object.hpp"
+#include "../header/evaluator.hpp"
+
+// AST pass run between parsing and evaluation. Prefix and infix expressions
+// whose operands are literals are folded into the literal they evaluate to,
+// bottom up, so 60 * 60 * 24 becomes 86400. Every integer literal then gets
+// the Integer it evaluates to, which evaluation hands out instead of
+// allocating one each time. String literals keep allocating, push() appends
+// to a string in place. Operations that would fail are left for evaluation
+// to report.
+//
+// Calls of small global functions are inlined: a function bound once by a
+// top-level let that is never assigned, whose body is a single expression of
+// its parameters, literals and operators, can't recurse and has no effects.
+// Its calls with side effect free arguments become an InlinedCall holding the
+// body with the arguments substituted, which still checks at run time that the
+// name refers to that function.
+#define INLINE_MAX_NODES 16 // size of the largest body expression inlined
+
+class Optimizer
+{
+private:
+	Evaluator evaluator; // folds with the operator semantics evaluation uses
+
+	std::unordered_map<std::string, FunctionLiteral *> inlinable;
+	std::vector<std::unordered_set<std::string>> scopes; // names declared by the functions being optimized
+
+	void collectInlinable(Program *program);
+	Expression *inlineCall(CallExpression *call);
+
+	void optimize(Node *node);
+	void optimizeAll(std::vector<Expression *> &exprs);
+	Expression *fold(Expression *expr);
+	Object *literalValue(Expression *expr);
+	Expression *toLiteral(Object *value);
+
+public:
+	void Optimize(Program *program);
+};
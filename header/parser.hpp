@@ -45,9 +45,11 @@ private:
 
 	LetStatement *parseLetStatement();
 	AssignStatement *parseAssignStatement();
+	AssignStatement *parseCompoundAssignStatement();
+	IndexAssignStatement *parseIndexAssignStatement(IndexExpression *target);
 	ReturnStatement *parseReturnStatement();
 	BlockStatement *parseBlockStatement();
-	ExpressionStatement *parseExpressionStatement();
+	Statement *parseExpressionStatement();
 
 	std::vector<Identifier *> parseFunctionParameters();
 	std::vector<Expression *> parseExpressionList();
@@ -62,6 +64,7 @@ private:
 	Expression *parseWhileExpression();
 	Expression *parseCallExpression(Expression *function);
 	Expression *parseIndexExpression(Expression *array);
+	Expression *parseSliceExpression(Token token, Expression *array, Expression *start);
 
 	Expression *parseIdentifier();
 
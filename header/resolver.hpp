@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+
+#include "../header/ast.hpp"
+#include "../header/object.hpp"
+#include "../header/environment.hpp"
+
+// Binds identifiers naming a builtin directly to it, once, before evaluation.
+// A name counts as shadowed in a scope (the program or a function body) if it
+// is a parameter or let anywhere in that scope, because bindings live in one
+// Environment per call and a let may run before or after the reference.
+// Shadowed and all other identifiers are left to the Environment lookup.
+// Calls of a bound builtin get their arity checked here as well.
+class Resolver
+{
+private:
+	std::vector<std::unordered_set<std::string>> scopes;
+	std::unordered_map<std::string, std::vector<Identifier *>> bound; // by name, over all programs resolved so far
+
+	void resolve(Node *node);
+	bool shadowed(std::string &name);
+
+public:
+	// names already bound in env (earlier REPL lines) shadow builtins as well.
+	// A program declaring a global that names a builtin unbinds the identifiers
+	// earlier programs bound to it, so functions defined on earlier REPL lines
+	// see the new global like the plain evaluator would.
+	void Resolve(Program *program, Environment *env);
+};
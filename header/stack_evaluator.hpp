@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "../header/ast.hpp"
+#include "../header/object.hpp"
+#include "../header/environment.hpp"
+#include "../header/evaluator.hpp"
+
+// What a frame evaluates, resolved from nodeType() once when it is pushed
+enum StackFrameKind
+{
+	FRAME_PROGRAM,
+	FRAME_BLOCK,
+	FRAME_IF,
+	FRAME_WHILE,
+	FRAME_CALL,
+	FRAME_TAIL_CALL, // return statement whose value is a call, inside a function
+	FRAME_VALUE,	 // literals, identifiers and function literals, no operands
+	FRAME_OPERANDS,	 // everything else: operands in order, then combined
+};
+
+struct StackFrame
+{
+	Node *node;
+	Environment *env;
+	StackFrameKind kind;
+
+	int stage = 0;				  // statements run / operands evaluated so far, meaning depends on kind
+	std::vector<Object *> values; // operands evaluated so far
+	Object *last = nullptr;		  // value of the last statement of a block or program
+	Function *callee = nullptr;	  // call frames: function whose body is running
+	Environment *calleeEnv = nullptr;
+
+	StackFrame(Node *node, Environment *env, StackFrameKind kind) : node(node), env(env), kind(kind) {}
+};
+
+// Evaluator that keeps its frames on a heap allocated stack instead of
+// recursing on the native one, so recursion in mod is only limited by
+// maxDepth (nested mod calls) and memory. Exceeding maxDepth stops the
+// program with an Error.
+class StackEvaluator
+{
+private:
+	Evaluator evaluator; // shared operator, index and builtin semantics
+
+	std::vector<StackFrame> frames;
+	int depth = 0; // mod function calls in progress
+	int maxDepth;
+	Object *overflow = nullptr;
+	bool returning = false; // as in Evaluator, no wrapper object for returned values
+	TailCall tailCall;
+
+	void push(Node *node, Environment *env);
+	Object *step(size_t frame, Object *value);
+
+	Object *stepProgram(size_t frame, Object *value);
+	Object *stepBlock(size_t frame, Object *value);
+	Object *stepIf(size_t frame, Object *value);
+	Object *stepWhile(size_t frame, Object *value);
+	Object *stepCall(size_t frame, Object *value);
+	Object *stepOperands(size_t frame, Object *value);
+	Object *evalValue(Node *node, Environment *env);
+
+	Node *operand(StackFrame &frame, size_t i);
+	Object *combine(StackFrame &frame);
+	Object *enterFunction(size_t frame, Function *fn, std::vector<Object *> &args, Environment *reuse);
+
+public:
+	StackEvaluator(int maxDepth = 1000000) : maxDepth(maxDepth) {}
+
+	Object *Eval(Node *node, Environment *env);
+};
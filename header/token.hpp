@@ -33,6 +33,11 @@ const TokenType ASTERISK = "*";
 const TokenType SLASH = "/";
 const TokenType MODULO = "%";
 
+// compound assignment
+const TokenType PLUS_ASSIGN = "+=";
+const TokenType MINUS_ASSIGN = "-=";
+const TokenType ASTERISK_ASSIGN = "*=";
+
 // comparison
 const TokenType LT = "<";
 const TokenType GT = ">";
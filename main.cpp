@@ -6,6 +6,10 @@
 #include "./header/lexer.hpp"
 #include "./header/parser.hpp"
 #include "./header/evaluator.hpp"
+#include "./header/resolver.hpp"
+#include "./header/optimizer.hpp"
+#include "./header/closure_compiler.hpp"
+#include "./header/stack_evaluator.hpp"
 
 std::string readFile(const std::string &fileName)
 {
@@ -28,12 +32,36 @@ std::string readFile(const std::string &fileName)
 
 int main(int argc, char *argv[])
 {
-	if (argc < 2) {
+	std::string filename;
+	bool closureMode = false; // --closure : run on the closure compilation tier
+	bool jitMode = false;	  // --jit : compile hot functions and loops to native code
+	bool osrMode = false;	  // --osr : move hot loops to the closure compilation tier
+	bool stackMode = false;	  // --stack : keep mod call frames on the heap, for deep recursion
+	int maxDepth = 1000000;	  // --max-depth=N : nested calls allowed in --stack mode
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg(argv[i]);
+
+		if (arg == "--closure")
+			closureMode = true;
+		else if (arg == "--jit")
+			jitMode = true;
+		else if (arg == "--osr")
+			osrMode = true;
+		else if (arg == "--stack")
+			stackMode = true;
+		else if (arg.compare(0, 12, "--max-depth=") == 0)
+			maxDepth = atoi(arg.c_str() + 12);
+		else
+			filename = arg;
+	}
+
+	if (filename.empty()) {
 		std::cout << "error: file name not specified" << std::endl;
 		exit(1);
 	}
 
-	std::string filename(argv[1]);
 	std::string input = readFile(filename);
 
 	if (input.empty())
@@ -60,7 +88,38 @@ int main(int argc, char *argv[])
 		return 0;
 	}
 
-	Object *obj = evaluator.Eval(program, env);
+	Optimizer optimizer;
+	optimizer.Optimize(program);
+
+	Resolver resolver;
+	resolver.Resolve(program, env);
+
+	if (jitMode)
+	{
+		if (Jit::Supported())
+			evaluator.EnableJit(new Jit());
+		else
+			std::cerr << "warning: jit is only supported on x86-64 linux, interpreting instead" << std::endl;
+	}
+
+	if (jitMode || osrMode)
+		evaluator.EnableOsr();
+
+	Object *obj;
+
+	if (closureMode)
+	{
+		ClosureCompiler compiler;
+		obj = compiler.Run(compiler.Compile(program), env);
+	}
+	else if (stackMode)
+	{
+		StackEvaluator stackEvaluator(maxDepth);
+		obj = stackEvaluator.Eval(program, env);
+	}
+	else
+		obj = evaluator.Eval(program, env);
+
 	if (obj->type() != NULL_OBJ)
 		std::cout << obj->inspect() << std::endl;
 
@@ -4,6 +4,8 @@
 #include "./header/lexer.hpp"
 #include "./header/parser.hpp"
 #include "./header/evaluator.hpp"
+#include "./header/resolver.hpp"
+#include "./header/optimizer.hpp"
 
 // Read Evaluate Print Loop
 void REPL()
@@ -13,6 +15,8 @@ void REPL()
 	Lexer lexer;
 	Parser parser;
 	Evaluator evaluator;
+	Resolver resolver;
+	Optimizer optimizer;
 
 	Environment *env = new Environment();
 
@@ -37,6 +41,9 @@ void REPL()
 				std::cout << error << std::endl;
 
 		else {
+			optimizer.Optimize(program);
+			resolver.Resolve(program, env);
+
 			Object *obj = evaluator.Eval(program, env);
 			if (obj != __NULL)
 				std::cout << obj->inspect() << std::endl;
@@ -2,14 +2,17 @@
 #include <string>
 
 #include "./header/parser.hpp"
+#include "./header/optimizer.hpp"
 
 // Read "Parse" Print Loop
-void RPPL()
+// dumpOptimized : print the program as the Optimizer leaves it
+void RPPL(bool dumpOptimized)
 {
 	const std::string PROMPT = ">> ";
 
 	Lexer lexer;
 	Parser parser;
+	Optimizer optimizer;
 	
 	std::string line;
 
@@ -28,15 +31,22 @@ void RPPL()
 			for (std::string error : parser.Errors())
 				std::cout << error << std::endl;
 		else
+		{
+			if (dumpOptimized)
+				optimizer.Optimize(program);
+
 			std::cout << program->getStringRepr() << std::endl;
+		}
 
 		parser.resetErrors();
 	}
 }
 
-int main()
+int main(int argc, char *argv[])
 {
-	RPPL();
+	bool dumpOptimized = argc > 1 && std::string(argv[1]) == "--dump-optimized";
+
+	RPPL(dumpOptimized);
 
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "../header/array_kernels.hpp"
+
+#ifdef MOD_ARRAY_SSE2
+#include <emmintrin.h>
+
+#define ARRAY_LANES 4
+
+static __m128i load(const int *values)
+{
+	return _mm_loadu_si128((const __m128i *)values);
+}
+
+static void store(int *values, __m128i v)
+{
+	_mm_storeu_si128((__m128i *)values, v);
+}
+
+// SSE2 has no 32 bit signed min and max or low multiply, they came with SSE4.1
+static __m128i minLanes(__m128i a, __m128i b)
+{
+	__m128i less = _mm_cmplt_epi32(a, b);
+	return _mm_or_si128(_mm_and_si128(less, a), _mm_andnot_si128(less, b));
+}
+
+static __m128i maxLanes(__m128i a, __m128i b)
+{
+	__m128i greater = _mm_cmpgt_epi32(a, b);
+	return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+}
+
+static __m128i mulLanes(__m128i a, __m128i b)
+{
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+							  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+#endif
+
+int sumInts(const int *values, size_t n)
+{
+	unsigned sum = 0; // unsigned, so wrapping around is defined
+	size_t i = 0;
+
+#ifdef MOD_ARRAY_SSE2
+	__m128i lanes = _mm_setzero_si128();
+
+	for (; i + ARRAY_LANES <= n; i += ARRAY_LANES)
+		lanes = _mm_add_epi32(lanes, load(values + i));
+
+	int partial[ARRAY_LANES];
+	store(partial, lanes);
+
+	for (int lane = 0; lane < ARRAY_LANES; lane++)
+		sum += partial[lane];
+#endif
+
+	for (; i < n; i++)
+		sum += values[i];
+
+	return (int)sum;
+}
+
+int minInts(const int *values, size_t n)
+{
+	int min = values[0];
+	size_t i = 0;
+
+#ifdef MOD_ARRAY_SSE2
+	if (n >= ARRAY_LANES)
+	{
+		__m128i lanes = load(values);
+
+		for (i = ARRAY_LANES; i + ARRAY_LANES <= n; i += ARRAY_LANES)
+			lanes = minLanes(lanes, load(values + i));
+
+		int partial[ARRAY_LANES];
+		store(partial, lanes);
+
+		for (int lane = 0; lane < ARRAY_LANES; lane++)
+			min = partial[lane] < min ? partial[lane] : min;
+	}
+#endif
+
+	for (; i < n; i++)
+		min = values[i] < min ? values[i] : min;
+
+	return min;
+}
+
+int maxInts(const int *values, size_t n)
+{
+	int max = values[0];
+	size_t i = 0;
+
+#ifdef MOD_ARRAY_SSE2
+	if (n >= ARRAY_LANES)
+	{
+		__m128i lanes = load(values);
+
+		for (i = ARRAY_LANES; i + ARRAY_LANES <= n; i += ARRAY_LANES)
+			lanes = maxLanes(lanes, load(values + i));
+
+		int partial[ARRAY_LANES];
+		store(partial, lanes);
+
+		for (int lane = 0; lane < ARRAY_LANES; lane++)
+			max = partial[lane] > max ? partial[lane] : max;
+	}
+#endif
+
+	for (; i < n; i++)
+		max = values[i] > max ? values[i] : max;
+
+	return max;
+}
+
+long findInt(const int *values, size_t n, int value)
+{
+	size_t i = 0;
+
+#ifdef MOD_ARRAY_SSE2
+	__m128i wanted = _mm_set1_epi32(value);
+
+	for (; i + ARRAY_LANES <= n; i += ARRAY_LANES)
+	{
+		// 4 mask bits per matching lane
+		int bits = _mm_movemask_epi8(_mm_cmpeq_epi32(load(values + i), wanted));
+
+		if (bits != 0)
+			return i + __builtin_ctz(bits) / 4;
+	}
+#endif
+
+	for (; i < n; i++)
+		if (values[i] == value)
+			return i;
+
+	return -1;
+}
+
+void addInts(const int *a, const int *b, int *out, size_t n)
+{
+	size_t i = 0;
+
+#ifdef MOD_ARRAY_SSE2
+	for (; i + ARRAY_LANES <= n; i += ARRAY_LANES)
+		store(out + i, _mm_add_epi32(load(a + i), load(b + i)));
+#endif
+
+	for (; i < n; i++)
+		out[i] = (unsigned)a[i] + (unsigned)b[i];
+}
+
+void subInts(const int *a, const int *b, int *out, size_t n)
+{
+	size_t i = 0;
+
+#ifdef MOD_ARRAY_SSE2
+	for (; i + ARRAY_LANES <= n; i += ARRAY_LANES)
+		store(out + i, _mm_sub_epi32(load(a + i), load(b + i)));
+#endif
+
+	for (; i < n; i++)
+		out[i] = (unsigned)a[i] - (unsigned)b[i];
+}
+
+void mulInts(const int *a, const int *b, int *out, size_t n)
+{
+	size_t i = 0;
+
+#ifdef MOD_ARRAY_SSE2
+	for (; i + ARRAY_LANES <= n; i += ARRAY_LANES)
+		store(out + i, mulLanes(load(a + i), load(b + i)));
+#endif
+
+	for (; i < n; i++)
+		out[i] = (unsigned)a[i] * (unsigned)b[i];
+}
@@ -1,6 +1,8 @@
 #include "../header/ast.hpp"
 
 #include <iostream>
+#include <algorithm>
+#include <unordered_set>
 
 std::string Program::tokenLiteral()
 {
@@ -31,7 +33,35 @@ std::string LetStatement::getStringRepr()
 
 std::string AssignStatement::getStringRepr()
 {
-	std::string res = name.getStringRepr() + " = " + value->getStringRepr();
+	InfixExpression *expr = compound();
+	std::string res;
+
+	if (expr != nullptr)
+		res = name.getStringRepr() + " " + op + "= " + expr->right->getStringRepr();
+	else
+		res = name.getStringRepr() + " = " + value->getStringRepr();
+
+	res.push_back(';');
+
+	return res;
+}
+
+InfixExpression *AssignStatement::compound()
+{
+	if (op.empty() || value->nodeType() != "InfixExpression")
+		return nullptr;
+
+	InfixExpression *expr = (InfixExpression *)value;
+
+	if (expr->operand != op || expr->left->nodeType() != "Identifier" || ((Identifier *)expr->left)->value != name.value)
+		return nullptr;
+
+	return expr;
+}
+
+std::string IndexAssignStatement::getStringRepr()
+{
+	std::string res = target->getStringRepr() + " = " + value->getStringRepr();
 
 	res.push_back(';');
 
@@ -141,6 +171,11 @@ std::string CallExpression::getStringRepr()
 	return res;
 }
 
+std::string InlinedCall::getStringRepr()
+{
+	return "inline " + call->getStringRepr() + " => " + expression->getStringRepr();
+}
+
 std::string ArrayLiteral::getStringRepr()
 {
 	std::string res = "[";
@@ -164,6 +199,11 @@ std::string IndexExpression::getStringRepr()
 	return array->getStringRepr() + "[" + index->getStringRepr() + "]";
 }
 
+std::string SliceExpression::getStringRepr()
+{
+	return array->getStringRepr() + "[" + start->getStringRepr() + ":" + (end != nullptr ? end->getStringRepr() : "") + "]";
+}
+
 std::string HashMapLiteral::getStringRepr()
 {
 	std::string res = "{";
@@ -288,4 +328,219 @@ std::string MinHeapLiteral::getStringRepr()
 	res.push_back('}');
 
 	return res;
-}
\ No newline at end of file
+}
+
+void declaredNames(Node *node, std::unordered_set<std::string> &names)
+{
+	std::string nodeType = node->nodeType();
+
+	if (nodeType == "FunctionLiteral")
+		return;
+
+	if (nodeType == "LetStatement")
+		names.insert(((LetStatement *)node)->name.value);
+
+	for (auto child : childNodes(node))
+		declaredNames(child, names);
+}
+
+// Free variable analysis, run from the outermost function literal so every
+// literal nested in it learns which names its enclosing functions declare.
+// A name counts as declared by a function if it is a parameter or let anywhere
+// in its body, the same scoping the Resolver uses.
+static std::unordered_set<std::string> analyzeCaptures(FunctionLiteral *fn, std::vector<std::unordered_set<std::string>> &enclosing);
+
+static void referencedNames(Node *node, std::unordered_set<std::string> &names, std::vector<std::unordered_set<std::string>> &enclosing)
+{
+	std::string nodeType = node->nodeType();
+
+	if (nodeType == "Identifier")
+		names.insert(((Identifier *)node)->value);
+
+	else if (nodeType == "AssignStatement")
+		names.insert(((AssignStatement *)node)->name.value);
+
+	else if (nodeType == "FunctionLiteral")
+	{
+		for (auto &name : analyzeCaptures((FunctionLiteral *)node, enclosing))
+			names.insert(name);
+
+		return;
+	}
+
+	for (auto child : childNodes(node))
+		referencedNames(child, names, enclosing);
+}
+
+static void assignedNames(Node *node, std::unordered_set<std::string> &names)
+{
+	std::string nodeType = node->nodeType();
+
+	if (nodeType == "FunctionLiteral")
+		return;
+
+	if (nodeType == "AssignStatement")
+		names.insert(((AssignStatement *)node)->name.value);
+
+	for (auto child : childNodes(node))
+		assignedNames(child, names);
+}
+
+// Points the identifiers of fn's body at the captured variable they read,
+// except for names fn assigns, which then become bindings of its own frame
+static void indexCaptures(Node *node, FunctionLiteral *fn, std::unordered_set<std::string> &assigned)
+{
+	std::string nodeType = node->nodeType();
+
+	if (nodeType == "FunctionLiteral")
+		return;
+
+	if (nodeType == "Identifier" && !assigned.count(((Identifier *)node)->value))
+	{
+		for (size_t i = 0; i < fn->captures.size(); i++)
+			if (fn->captures[i] == ((Identifier *)node)->value)
+				((Identifier *)node)->capture = i;
+	}
+
+	for (auto child : childNodes(node))
+		indexCaptures(child, fn, assigned);
+}
+
+// sets captures of fn and the literals inside it, returns the free variables of fn
+static std::unordered_set<std::string> analyzeCaptures(FunctionLiteral *fn, std::vector<std::unordered_set<std::string>> &enclosing)
+{
+	std::unordered_set<std::string> declared;
+
+	for (auto param : fn->parameters)
+		declared.insert(param->value);
+
+	declaredNames(fn->body, declared);
+
+	std::unordered_set<std::string> referenced;
+
+	enclosing.push_back(declared);
+	referencedNames(fn->body, referenced, enclosing);
+	enclosing.pop_back();
+
+	std::unordered_set<std::string> free;
+	fn->captures.clear();
+
+	for (auto &name : referenced)
+	{
+		if (declared.count(name))
+			continue;
+
+		free.insert(name);
+
+		for (auto &scope : enclosing)
+		{
+			if (scope.count(name))
+			{
+				fn->captures.push_back(name);
+				break;
+			}
+		}
+	}
+
+	std::unordered_set<std::string> assigned;
+	assignedNames(fn->body, assigned);
+	indexCaptures(fn->body, fn, assigned);
+
+	fn->capturesAnalyzed = true;
+	return free;
+}
+
+// A literal not analyzed yet is an outermost one, it captures nothing itself
+std::vector<std::string> &FunctionLiteral::Captures()
+{
+	if (!capturesAnalyzed)
+	{
+		std::vector<std::unordered_set<std::string>> enclosing;
+		analyzeCaptures(this, enclosing);
+	}
+
+	return captures;
+}
+
+std::vector<Node *> childNodes(Node *node)
+{
+	std::vector<Node *> children;
+
+	if (node == nullptr)
+		return children;
+
+	std::string nodeType = node->nodeType();
+
+	if (nodeType == "Program")
+		children.assign(((Program *)node)->statements.begin(), ((Program *)node)->statements.end());
+	else if (nodeType == "BlockStatement")
+		children.assign(((BlockStatement *)node)->statements.begin(), ((BlockStatement *)node)->statements.end());
+	else if (nodeType == "LetStatement")
+		children.push_back(((LetStatement *)node)->value);
+	else if (nodeType == "AssignStatement")
+		children.push_back(((AssignStatement *)node)->value);
+	else if (nodeType == "IndexAssignStatement")
+		children = {((IndexAssignStatement *)node)->target, ((IndexAssignStatement *)node)->value};
+	else if (nodeType == "ReturnStatement")
+		children.push_back(((ReturnStatement *)node)->returnValue);
+	else if (nodeType == "ExpressionStatement")
+		children.push_back(((ExpressionStatement *)node)->expression);
+	else if (nodeType == "PrefixExpression")
+		children.push_back(((PrefixExpression *)node)->right);
+	else if (nodeType == "InfixExpression")
+		children = {((InfixExpression *)node)->left, ((InfixExpression *)node)->right};
+	else if (nodeType == "IfExpression")
+	{
+		children = {((IfExpression *)node)->condition, ((IfExpression *)node)->consequence};
+		if (((IfExpression *)node)->alternative != nullptr)
+			children.push_back(((IfExpression *)node)->alternative);
+	}
+	else if (nodeType == "WhileExpression")
+		children = {((WhileExpression *)node)->condition, ((WhileExpression *)node)->consequence};
+	else if (nodeType == "FunctionLiteral")
+		children.push_back(((FunctionLiteral *)node)->body);
+	else if (nodeType == "CallExpression")
+	{
+		children.push_back(((CallExpression *)node)->function);
+		children.insert(children.end(), ((CallExpression *)node)->arguments.begin(), ((CallExpression *)node)->arguments.end());
+	}
+	else if (nodeType == "InlinedCall")
+		children = {((InlinedCall *)node)->expression, ((InlinedCall *)node)->call};
+	else if (nodeType == "IndexExpression")
+		children = {((IndexExpression *)node)->array, ((IndexExpression *)node)->index};
+	else if (nodeType == "SliceExpression")
+	{
+		SliceExpression *slice = (SliceExpression *)node;
+		children = {slice->array, slice->start};
+
+		if (slice->end != nullptr)
+			children.push_back(slice->end);
+	}
+	else if (nodeType == "ArrayLiteral")
+		children.assign(((ArrayLiteral *)node)->elements.begin(), ((ArrayLiteral *)node)->elements.end());
+	else if (nodeType == "HashMapLiteral")
+	{
+		for (auto pair : ((HashMapLiteral *)node)->pairs)
+		{
+			children.push_back(pair.key);
+			children.push_back(pair.value);
+		}
+	}
+	else if (nodeType == "HashSetLiteral")
+		children.assign(((HashSetLiteral *)node)->pairs.begin(), ((HashSetLiteral *)node)->pairs.end());
+	else if (nodeType == "StackLiteral")
+		children.assign(((StackLiteral *)node)->elements.begin(), ((StackLiteral *)node)->elements.end());
+	else if (nodeType == "QueueLiteral")
+		children.assign(((QueueLiteral *)node)->elements.begin(), ((QueueLiteral *)node)->elements.end());
+	else if (nodeType == "DequeLiteral")
+		children.assign(((DequeLiteral *)node)->elements.begin(), ((DequeLiteral *)node)->elements.end());
+	else if (nodeType == "MaxHeapLiteral")
+		children.assign(((MaxHeapLiteral *)node)->elements.begin(), ((MaxHeapLiteral *)node)->elements.end());
+	else if (nodeType == "MinHeapLiteral")
+		children.assign(((MinHeapLiteral *)node)->elements.begin(), ((MinHeapLiteral *)node)->elements.end());
+
+	// null sub-nodes (like an empty expression statement) are left out
+	children.erase(std::remove(children.begin(), children.end(), (Node *)nullptr), children.end());
+
+	return children;
+}
@@ -0,0 +1,588 @@
+#include "../header/builtins.hpp"
+#include "../header/array_kernels.hpp"
+
+Object *Print(Arguments objs)
+{
+	for (auto obj : objs)
+	{
+		if (obj->isError())
+			return obj;
+
+		std::cout << obj->inspect() << " ";
+	}
+
+	std::cout << std::endl;
+
+	return __NULL;
+}
+
+Object *Len(Arguments objs)
+{
+	Object *obj = objs[0];
+	ObjectType type = obj->type();
+
+	if (obj->isError())
+		return obj;
+
+	else if (type == STRING_OBJ)
+		return new Integer(((String *)obj)->length());
+
+	else if (type == ARRAY_OBJ)
+		return new Integer(((Array *)obj)->size());
+
+	else if (type == HASHMAP_OBJ)
+		return new Integer(((HashMap *)obj)->pairs.size());
+
+	return new Error("error: unsupported object for len()");
+}
+
+Object *Size(Arguments objs)
+{
+	Object *obj = objs[0];
+	ObjectType type = obj->type();
+
+	if (obj->isError())
+		return obj;
+
+	else if (type == HASHSET_OBJ)
+		return new Integer(((HashSet *)obj)->pairs.size());
+
+	else if (type == STACK_OBJ)
+		return new Integer(((Stack *)obj)->elements.size());
+
+	else if (type == QUEUE_OBJ)
+		return new Integer(((Queue *)obj)->elements.size());
+
+	else if (type == DEQUE_OBJ)
+		return new Integer(((Deque *)obj)->elements.size());
+
+	else if (type == MAXHEAP_OBJ)
+		return new Integer(((MaxHeap *)obj)->elements.size());
+
+	else if (type == MINHEAP_OBJ)
+		return new Integer(((MinHeap *)obj)->elements.size());
+
+	return new Error("error: unsupported object for len()");
+}
+
+Object *Push(Arguments objs)
+{
+	Object *obj = objs[0];
+	const ObjectType type = obj->type();
+
+	if (obj->isError())
+		return obj;
+
+	if (objs[1]->isError())
+		return objs[1];
+
+	else if (type == STRING_OBJ)
+	{
+		if (objs[1]->type() != STRING_OBJ)
+			return new Error("error: expected " + STRING_OBJ + " got " + objs[1]->type());
+
+		((String *)obj)->append(((String *)objs[1])->value());
+		return __NULL;
+	}
+
+	else if (type == ARRAY_OBJ)
+	{
+		((Array *)obj)->push(objs[1]);
+		return __NULL;
+	}
+
+	else if (type == STACK_OBJ)
+	{
+		((Stack *)obj)->elements.push(objs[1]);
+		return __NULL;
+	}
+
+	else if (type == QUEUE_OBJ)
+	{
+		((Queue *)obj)->elements.push(objs[1]);
+		return __NULL;
+	}
+
+	else if (type == MAXHEAP_OBJ)
+	{
+		if (objs[1]->type() != ((MaxHeap *)obj)->tokenType)
+			return new Error("error: expected " + ((MaxHeap *)obj)->tokenType + " got " + objs[1]->type());
+
+		((MaxHeap *)obj)->elements.push(objs[1]);
+		return __NULL;
+	}
+
+	else if (type == MINHEAP_OBJ)
+	{
+		((MinHeap *)obj)->elements.push(objs[1]);
+		return __NULL;
+	}
+
+	return new Error("error: unsupported object for push()");
+}
+
+Object *Push_Front(Arguments objs)
+{
+	Object *obj = objs[0];
+	const ObjectType type = obj->type();
+
+	if (obj->isError())
+		return obj;
+
+	if (objs[1]->isError())
+		return objs[1];
+
+	else if (type == DEQUE_OBJ)
+	{
+		((Deque *)obj)->elements.push_front(objs[1]);
+		return __NULL;
+	}
+
+	return new Error("error: unsupported object for push()");
+}
+Object *Push_Back(Arguments objs)
+{
+	Object *obj = objs[0];
+	const ObjectType type = obj->type();
+
+	if (obj->isError())
+		return obj;
+
+	if (objs[1]->isError())
+		return objs[1];
+
+	else if (type == DEQUE_OBJ)
+	{
+		((Deque *)obj)->elements.push_back(objs[1]);
+		return __NULL;
+	}
+
+	return new Error("error: unsupported object for push()");
+}
+
+Object *Pop(Arguments objs)
+{
+	Object *obj = objs[0];
+	ObjectType type = obj->type();
+
+	if (obj->isError())
+		return obj;
+
+	else if (type == STRING_OBJ)
+	{
+		if (!((String *)obj)->popBack())
+			return new Error("error: cannot pop from empty string");
+		return __NULL;
+	}
+
+	else if (type == ARRAY_OBJ)
+	{
+		if (((Array *)obj)->size() == 0)
+			return new Error("error: cannot pop from empty array");
+
+		((Array *)obj)->pop();
+		return __NULL;
+	}
+
+	else if (type == STACK_OBJ)
+	{
+		if (((Stack *)obj)->elements.empty())
+			return new Error("error: cannot pop from empty stack");
+
+		((Stack *)obj)->elements.pop();
+		return __NULL;
+	}
+
+	else if (type == QUEUE_OBJ)
+	{
+		if (((Queue *)obj)->elements.empty())
+			return new Error("error: cannot pop from empty queue");
+
+		((Queue *)obj)->elements.pop();
+		return __NULL;
+	}
+
+	else if (type == MAXHEAP_OBJ)
+	{
+		if (((MaxHeap *)obj)->elements.empty())
+			return new Error("error: cannot pop from empty heap");
+
+		((MaxHeap *)obj)->elements.pop();
+		return __NULL;
+	}
+
+	else if (type == MINHEAP_OBJ)
+	{
+		if (((MinHeap *)obj)->elements.empty())
+			return new Error("error: cannot pop from empty heap");
+
+		((MinHeap *)obj)->elements.pop();
+		return __NULL;
+	}
+
+	return new Error("error: unsupported object for pop()");
+}
+
+Object *Pop_Front(Arguments objs)
+{
+	Object *obj = objs[0];
+	ObjectType type = obj->type();
+
+	if (obj->isError())
+		return obj;
+
+	else if (type == DEQUE_OBJ)
+	{
+		if (((Deque *)obj)->elements.empty())
+			return new Error("error: cannot pop from empty deque");
+
+		((Deque *)obj)->elements.pop_front();
+		return __NULL;
+	}
+
+	return new Error("error: unsupported object for pop_front()");
+}
+
+Object *Pop_Back(Arguments objs)
+{
+	Object *obj = objs[0];
+	ObjectType type = obj->type();
+
+	if (obj->isError())
+		return obj;
+
+	else if (type == DEQUE_OBJ)
+	{
+		if (((Deque *)obj)->elements.empty())
+			return new Error("error: cannot pop from empty deque");
+
+		((Deque *)obj)->elements.pop_back();
+		return __NULL;
+	}
+
+	return new Error("error: unsupported object for pop_back()");
+}
+
+Object *Insert(Arguments objs)
+{
+	if (objs.size() == 0)
+		return new Error(ERROR_ARGUMENT_LENGTH, 0, 2);
+
+	Object *obj = objs[0];
+	ObjectType type = obj->type();
+
+	if (obj->isError())
+		return obj;
+
+	else if (type == HASHSET_OBJ)
+	{
+		if (objs.size() != 2)
+			return new Error("error: argument length (" + std::to_string(objs.size()) + ") not equal to parameter length (2) for hashset");
+
+		if (objs[1]->isError())
+			return objs[1];
+
+		((HashSet *)obj)->pairs.insert(HashKey(objs[1]), objs[1], objs[1]);
+
+		return __NULL;
+	}
+
+	else if (type == HASHMAP_OBJ)
+	{
+		if (objs.size() != 3)
+			return new Error("error: argument length (" + std::to_string(objs.size()) + ") not equal to parameter length (3) for hashmap");
+
+		if (objs[1]->isError())
+			return objs[1];
+
+		if (objs[2]->isError())
+			return objs[2];
+
+		((HashMap *)objs[0])->pairs.insert(HashKey(objs[1]), objs[1], objs[2]);
+
+		return __NULL;
+	}
+
+	return new Error("error: unsupported object for insert()");
+}
+
+Object *Remove(Arguments objs)
+{
+	Object *obj = objs[0];
+	ObjectType type = obj->type();
+
+	if (obj->isError())
+		return obj;
+
+	else if (type == HASHSET_OBJ)
+	{
+		if (((HashSet *)obj)->pairs.empty())
+			return new Error("error: cannot remove from empty hashset");
+
+		if (objs[1]->isError())
+			return objs[1];
+
+		if (!((HashSet *)obj)->pairs.erase(HashKey(objs[1])))
+			return new Error("error: key not found in hashset -> " + objs[1]->inspect());
+
+		return __NULL;
+	}
+
+	else if (type == HASHMAP_OBJ)
+	{
+		if (((HashMap *)obj)->pairs.empty())
+			return new Error("error: cannot remove from empty hashmap");
+
+		if (objs[1]->isError())
+			return objs[1];
+
+		if (!((HashMap *)obj)->pairs.erase(HashKey(objs[1])))
+			return new Error("error: key not found in hashmap -> " + objs[1]->inspect());
+
+		return __NULL;
+	}
+
+	return new Error("error: unsupported object for remove()");
+}
+
+Object *Find(Arguments objs)
+{
+	Object *obj = objs[0];
+	ObjectType type = obj->type();
+
+	if (obj->isError())
+		return obj;
+
+	if (objs[1]->isError())
+		return objs[1];
+
+	else if (type == STRING_OBJ)
+	{
+		if (objs[1]->type() != STRING_OBJ)
+			return new Error("error: expected " + STRING_OBJ + " got " + objs[1]->type());
+
+		size_t found = ((String *)obj)->value().find(((String *)objs[1])->value());
+		if (found == std::string::npos)
+			return new Integer(-1);
+		else
+			return new Integer((int)found);
+
+		return __NULL;
+	}
+
+	else if (type == ARRAY_OBJ)
+	{
+		Array *array = (Array *)obj;
+		Object *value = objs[1];
+
+		if (array->isPacked())
+			return new Integer(value->isInteger() ? findInt(array->intData(), array->size(), ((Integer *)value)->value) : -1);
+
+		Object **elems = array->data();
+
+		for (size_t i = 0; i < array->size(); i++)
+		{
+			if (value->isInteger() && elems[i]->isInteger())
+			{
+				if (((Integer *)elems[i])->value == ((Integer *)value)->value)
+					return new Integer(i);
+			}
+
+			else if (value->isString() && elems[i]->isString())
+			{
+				if (((String *)elems[i])->value() == ((String *)value)->value())
+					return new Integer(i);
+			}
+		}
+
+		return new Integer(-1);
+	}
+
+	else if (type == HASHMAP_OBJ)
+	{
+		if (((HashMap *)obj)->pairs.find(HashKey(objs[1])) != nullptr)
+			return __TRUE;
+		return __FALSE;
+	}
+
+	else if (type == HASHSET_OBJ)
+	{
+		if (((HashSet *)obj)->pairs.find(HashKey(objs[1])) != nullptr)
+			return __TRUE;
+		return __FALSE;
+	}
+
+	return __NULL;
+}
+
+// Values of an array of integers, the packed ones directly, boxed ones gathered into scratch.
+// Sets error for anything else
+static const int *intValues(Object *obj, const std::string &name, std::vector<int> &scratch, Object *&error)
+{
+	if (obj->isError())
+	{
+		error = obj;
+		return nullptr;
+	}
+
+	if (obj->type() != ARRAY_OBJ)
+	{
+		error = new Error("error: expected " + ARRAY_OBJ + " got " + obj->type());
+		return nullptr;
+	}
+
+	Array *array = (Array *)obj;
+
+	if (array->isPacked())
+		return array->intData();
+
+	scratch.resize(array->size());
+
+	for (size_t i = 0; i < array->size(); i++)
+	{
+		if (!array->data()[i]->isInteger())
+		{
+			error = new Error("error: " + name + " expects an array of " + INTEGER_OBJ);
+			return nullptr;
+		}
+
+		scratch[i] = ((Integer *)array->data()[i])->value;
+	}
+
+	return scratch.data();
+}
+
+Object *Sum(Arguments objs)
+{
+	std::vector<int> scratch;
+	Object *error = nullptr;
+	const int *values = intValues(objs[0], "sum", scratch, error);
+
+	if (error != nullptr)
+		return error;
+
+	return new Integer(sumInts(values, ((Array *)objs[0])->size()));
+}
+
+Object *Min(Arguments objs)
+{
+	std::vector<int> scratch;
+	Object *error = nullptr;
+	const int *values = intValues(objs[0], "min", scratch, error);
+
+	if (error != nullptr)
+		return error;
+
+	if (((Array *)objs[0])->size() == 0)
+		return new Error("error: min of empty array");
+
+	return new Integer(minInts(values, ((Array *)objs[0])->size()));
+}
+
+Object *Max(Arguments objs)
+{
+	std::vector<int> scratch;
+	Object *error = nullptr;
+	const int *values = intValues(objs[0], "max", scratch, error);
+
+	if (error != nullptr)
+		return error;
+
+	if (((Array *)objs[0])->size() == 0)
+		return new Error("error: max of empty array");
+
+	return new Integer(maxInts(values, ((Array *)objs[0])->size()));
+}
+
+typedef void (*IntsOpFn)(const int *a, const int *b, int *out, size_t n);
+
+// Element-wise op of an array with an array of the same length or with an integer
+static Object *elementWise(Arguments objs, const std::string &name, IntsOpFn op)
+{
+	std::vector<int> leftScratch, rightScratch;
+	Object *error = nullptr;
+	const int *left = intValues(objs[0], name, leftScratch, error);
+
+	if (error != nullptr)
+		return error;
+
+	size_t size = ((Array *)objs[0])->size();
+	const int *right;
+
+	if (objs[1]->isInteger())
+	{
+		rightScratch.assign(size, ((Integer *)objs[1])->value);
+		right = rightScratch.data();
+	}
+	else
+	{
+		right = intValues(objs[1], name, rightScratch, error);
+
+		if (error != nullptr)
+			return error;
+
+		if (((Array *)objs[1])->size() != size)
+			return new Error("error: " + name + " of arrays of length " + std::to_string(size) + " and " + std::to_string(((Array *)objs[1])->size()));
+	}
+
+	std::vector<int> result(size);
+	op(left, right, result.data(), size);
+
+	return new Array(result);
+}
+
+Object *Add(Arguments objs)
+{
+	return elementWise(objs, "add", addInts);
+}
+
+Object *Sub(Arguments objs)
+{
+	return elementWise(objs, "sub", subInts);
+}
+
+Object *Mul(Arguments objs)
+{
+	return elementWise(objs, "mul", mulInts);
+}
+
+Object *Type(Arguments objs)
+{
+	Object *obj = objs[0];
+	ObjectType type = obj->type();
+
+	if (obj->isError())
+		return obj;
+
+	std::cout << type << std::endl;
+
+	return __NULL;
+}
+
+std::unordered_map<std::string, Builtin *> builtin{
+	{"print", new Builtin(Print, BUILTIN_VARIADIC)},
+	{"type", new Builtin(Type, 1)},
+	{"len", new Builtin(Len, 1)},
+	{"size", new Builtin(Size, 1)},
+
+	{"push", new Builtin(Push, 2)},
+	{"push_front", new Builtin(Push_Front, 2)},
+	{"push_back", new Builtin(Push_Back, 2)},
+
+	{"pop", new Builtin(Pop, 1)},
+	{"pop_front", new Builtin(Pop_Front, 1)},
+	{"pop_back", new Builtin(Pop_Back, 1)},
+
+	// 2 arguments for a hashset, 3 for a hashmap, checked by insert itself
+	{"insert", new Builtin(Insert, BUILTIN_VARIADIC)},
+	{"remove", new Builtin(Remove, 2)},
+	{"find", new Builtin(Find, 2)},
+
+	// whole arrays of integers
+	{"sum", new Builtin(Sum, 1)},
+	{"min", new Builtin(Min, 1)},
+	{"max", new Builtin(Max, 1)},
+	{"add", new Builtin(Add, 2)},
+	{"sub", new Builtin(Sub, 2)},
+	{"mul", new Builtin(Mul, 2)},
+};
@@ -0,0 +1,805 @@
+#include "../header/closure_compiler.hpp"
+
+// Integer fast paths, mirroring Evaluator::evalIntegerInfixExpression
+
+static Object *intAdd(int l, int r) { return new Integer(l + r); }
+static Object *intSub(int l, int r) { return new Integer(l - r); }
+static Object *intMul(int l, int r) { return new Integer(l * r); }
+static Object *intDiv(int l, int r) { return r != 0 ? new Integer(l / r) : nullptr; }
+static Object *intMod(int l, int r) { return r != 0 ? new Integer(l % r) : nullptr; }
+static Object *intEq(int l, int r) { return l == r ? __TRUE : __FALSE; }
+static Object *intNeq(int l, int r) { return l != r ? __TRUE : __FALSE; }
+static Object *intGt(int l, int r) { return l > r ? __TRUE : __FALSE; }
+static Object *intLt(int l, int r) { return l < r ? __TRUE : __FALSE; }
+static Object *intGtEq(int l, int r) { return l >= r ? __TRUE : __FALSE; }
+static Object *intLtEq(int l, int r) { return l <= r ? __TRUE : __FALSE; }
+
+static IntegerOpFn lookupIntegerOp(const std::string &operand)
+{
+	if (operand == "+")
+		return intAdd;
+	else if (operand == "-")
+		return intSub;
+	else if (operand == "*")
+		return intMul;
+	else if (operand == "/")
+		return intDiv;
+	else if (operand == "%")
+		return intMod;
+	else if (operand == "==")
+		return intEq;
+	else if (operand == "!=")
+		return intNeq;
+	else if (operand == ">")
+		return intGt;
+	else if (operand == "<")
+		return intLt;
+	else if (operand == ">=")
+		return intGtEq;
+	else if (operand == "<=")
+		return intLtEq;
+
+	return nullptr;
+}
+
+CompiledNode *ClosureCompiler::Compile(Node *node)
+{
+	return compile(node);
+}
+
+Object *ClosureCompiler::Run(CompiledNode *code, Environment *env)
+{
+	return code->run(this, env);
+}
+
+CompiledNode *ClosureCompiler::newNode(CompiledFn fn, Node *node)
+{
+	CompiledNode *compiled = new CompiledNode();
+	compiled->fn = fn;
+	compiled->node = node;
+
+	return compiled;
+}
+
+CompiledNode *ClosureCompiler::compileBody(BlockStatement *body)
+{
+	if (body->compiled == nullptr)
+		body->compiled = compile(body);
+
+	return body->compiled;
+}
+
+CompiledNode *ClosureCompiler::compile(Node *node)
+{
+	if (node == nullptr)
+		return newNode(runNull, nullptr);
+
+	std::string nodeType = node->nodeType();
+	CompiledNode *compiled;
+
+	// Statements
+	if (nodeType == "Program")
+	{
+		compiled = newNode(runProgram, node);
+		for (auto stmt : ((Program *)node)->statements)
+			compiled->children.push_back(compile(stmt));
+	}
+
+	else if (nodeType == "ExpressionStatement")
+	{
+		compiled = newNode(runExpressionStatement, node);
+		compiled->children.push_back(compile(((ExpressionStatement *)node)->expression));
+	}
+
+	else if (nodeType == "BlockStatement")
+	{
+		compiled = newNode(runBlock, node);
+		for (auto stmt : ((BlockStatement *)node)->statements)
+			compiled->children.push_back(compile(stmt));
+	}
+
+	else if (nodeType == "ReturnStatement")
+	{
+		compiled = newNode(runReturn, node);
+		compiled->children.push_back(compile(((ReturnStatement *)node)->returnValue));
+	}
+
+	else if (nodeType == "LetStatement")
+	{
+		compiled = newNode(runLet, node);
+		compiled->name = ((LetStatement *)node)->name.value;
+		compiled->children.push_back(compile(((LetStatement *)node)->value));
+	}
+
+	else if (nodeType == "AssignStatement" && ((AssignStatement *)node)->compound() != nullptr)
+	{
+		compiled = newNode(runCompoundAssign, node);
+		compiled->name = ((AssignStatement *)node)->name.value;
+		compiled->operand = ((AssignStatement *)node)->op;
+		compiled->children.push_back(compile(((AssignStatement *)node)->compound()->right));
+	}
+
+	else if (nodeType == "AssignStatement")
+	{
+		compiled = newNode(runAssign, node);
+		compiled->name = ((AssignStatement *)node)->name.value;
+		compiled->children.push_back(compile(((AssignStatement *)node)->value));
+	}
+
+	else if (nodeType == "IndexAssignStatement")
+	{
+		compiled = newNode(runIndexAssign, node);
+		compiled->children.push_back(compile(((IndexAssignStatement *)node)->target->array));
+		compiled->children.push_back(compile(((IndexAssignStatement *)node)->target->index));
+		compiled->children.push_back(compile(((IndexAssignStatement *)node)->value));
+	}
+
+	// Expressions
+	else if (nodeType == "IntegerLiteral")
+	{
+		compiled = newNode(runIntegerLiteral, node);
+		compiled->intValue = ((IntegerLiteral *)node)->value;
+	}
+
+	else if (nodeType == "BooleanLiteral")
+	{
+		compiled = newNode(runBooleanLiteral, node);
+		compiled->boolValue = ((BooleanLiteral *)node)->value;
+	}
+
+	else if (nodeType == "StringLiteral")
+	{
+		compiled = newNode(runStringLiteral, node);
+		compiled->name = ((StringLiteral *)node)->value;
+	}
+
+	else if (nodeType == "PrefixExpression")
+	{
+		compiled = newNode(runPrefix, node);
+		compiled->operand = ((PrefixExpression *)node)->operand;
+		compiled->children.push_back(compile(((PrefixExpression *)node)->right));
+	}
+
+	else if (nodeType == "InfixExpression")
+	{
+		compiled = newNode(runInfix, node);
+		compiled->operand = ((InfixExpression *)node)->operand;
+		compiled->intOp = lookupIntegerOp(compiled->operand);
+		compiled->children.push_back(compile(((InfixExpression *)node)->left));
+		compiled->children.push_back(compile(((InfixExpression *)node)->right));
+	}
+
+	else if (nodeType == "IfExpression")
+	{
+		IfExpression *ifExpr = (IfExpression *)node;
+
+		compiled = newNode(runIf, node);
+		compiled->children.push_back(compile(ifExpr->condition));
+		compiled->children.push_back(compile(ifExpr->consequence));
+		if (ifExpr->alternative != nullptr)
+			compiled->children.push_back(compile(ifExpr->alternative));
+	}
+
+	else if (nodeType == "WhileExpression")
+	{
+		compiled = newNode(runWhile, node);
+		compiled->children.push_back(compile(((WhileExpression *)node)->condition));
+		compiled->children.push_back(compile(((WhileExpression *)node)->consequence));
+	}
+
+	else if (nodeType == "Identifier")
+	{
+		compiled = newNode(runIdentifier, node);
+		compiled->name = ((Identifier *)node)->value;
+	}
+
+	else if (nodeType == "FunctionLiteral")
+	{
+		compiled = newNode(runFunctionLiteral, node);
+		compileBody(((FunctionLiteral *)node)->body);
+	}
+
+	else if (nodeType == "CallExpression")
+	{
+		compiled = newNode(runCall, node);
+		compiled->children.push_back(compile(((CallExpression *)node)->function));
+		for (auto arg : ((CallExpression *)node)->arguments)
+			compiled->children.push_back(compile(arg));
+	}
+
+	else if (nodeType == "InlinedCall")
+	{
+		compiled = newNode(runInlinedCall, node);
+		compiled->children.push_back(compile(((InlinedCall *)node)->expression));
+		compiled->children.push_back(compile(((InlinedCall *)node)->call));
+	}
+
+	else if (nodeType == "ArrayLiteral")
+	{
+		compiled = newNode(runArrayLiteral, node);
+		for (auto elem : ((ArrayLiteral *)node)->elements)
+			compiled->children.push_back(compile(elem));
+	}
+
+	else if (nodeType == "IndexExpression")
+	{
+		compiled = newNode(runIndex, node);
+		compiled->children.push_back(compile(((IndexExpression *)node)->array));
+		compiled->children.push_back(compile(((IndexExpression *)node)->index));
+	}
+
+	else if (nodeType == "SliceExpression")
+	{
+		compiled = newNode(runSlice, node);
+		compiled->children.push_back(compile(((SliceExpression *)node)->array));
+		compiled->children.push_back(compile(((SliceExpression *)node)->start));
+
+		if (((SliceExpression *)node)->end != nullptr)
+			compiled->children.push_back(compile(((SliceExpression *)node)->end));
+	}
+
+	else if (nodeType == "HashMapLiteral")
+	{
+		compiled = newNode(runHashMapLiteral, node);
+		for (auto pair : ((HashMapLiteral *)node)->pairs)
+		{
+			compiled->children.push_back(compile(pair.key));
+			compiled->children.push_back(compile(pair.value));
+		}
+	}
+
+	else if (nodeType == "HashSetLiteral")
+	{
+		compiled = newNode(runHashSetLiteral, node);
+		for (auto elem : ((HashSetLiteral *)node)->pairs)
+			compiled->children.push_back(compile(elem));
+	}
+
+	else if (nodeType == "StackLiteral")
+	{
+		compiled = newNode(runStackLiteral, node);
+		for (auto elem : ((StackLiteral *)node)->elements)
+			compiled->children.push_back(compile(elem));
+	}
+
+	else if (nodeType == "QueueLiteral")
+	{
+		compiled = newNode(runQueueLiteral, node);
+		for (auto elem : ((QueueLiteral *)node)->elements)
+			compiled->children.push_back(compile(elem));
+	}
+
+	else if (nodeType == "DequeLiteral")
+	{
+		compiled = newNode(runDequeLiteral, node);
+		for (auto elem : ((DequeLiteral *)node)->elements)
+			compiled->children.push_back(compile(elem));
+	}
+
+	else if (nodeType == "MaxHeapLiteral")
+	{
+		compiled = newNode(runMaxHeapLiteral, node);
+		compiled->name = ((MaxHeapLiteral *)node)->type;
+		for (auto elem : ((MaxHeapLiteral *)node)->elements)
+			compiled->children.push_back(compile(elem));
+	}
+
+	else if (nodeType == "MinHeapLiteral")
+	{
+		compiled = newNode(runMinHeapLiteral, node);
+		compiled->name = ((MinHeapLiteral *)node)->type;
+		for (auto elem : ((MinHeapLiteral *)node)->elements)
+			compiled->children.push_back(compile(elem));
+	}
+
+	else
+		compiled = newNode(runNull, node);
+
+	return compiled;
+}
+
+// Statements
+
+Object *ClosureCompiler::runProgram(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Object *result = __NULL;
+
+	for (auto stmt : node->children)
+	{
+		result = stmt->run(cc, env);
+
+		if (cc->returning)
+		{
+			cc->returning = false;
+			return result;
+		}
+
+		else if (result->isError())
+			return result;
+	}
+
+	return result;
+}
+
+Object *ClosureCompiler::runBlock(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Object *result = __NULL;
+
+	for (auto stmt : node->children)
+	{
+		result = stmt->run(cc, env);
+		if (cc->returning || result->isError())
+			return result;
+	}
+
+	return result;
+}
+
+Object *ClosureCompiler::runExpressionStatement(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	return node->children[0]->run(cc, env);
+}
+
+Object *ClosureCompiler::runReturn(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Object *value;
+
+	if (cc->callDepth > 0 && node->children[0]->fn == runCall)
+	{
+		value = cc->call(node->children[0], env, true);
+
+		if (cc->tailCall.function != nullptr)
+			return value;
+	}
+	else
+		value = node->children[0]->run(cc, env);
+
+	if (value->isError())
+		return value;
+
+	cc->returning = true;
+	return value;
+}
+
+Object *ClosureCompiler::runLet(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Object *value = node->children[0]->run(cc, env);
+
+	if (value->isError())
+		return value;
+
+	env->Set(node->name, value);
+
+	return __NULL;
+}
+
+Object *ClosureCompiler::runAssign(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Object *value = node->children[0]->run(cc, env);
+
+	if (value->isError())
+		return value;
+
+	if (env->Lookup(node->name) == nullptr)
+		return new Error(ERROR_IDENTIFIER_NOT_FOUND, node->name);
+
+	env->Set(node->name, value);
+
+	return __NULL;
+}
+
+Object *ClosureCompiler::runCompoundAssign(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Object *right = node->children[0]->run(cc, env);
+
+	if (right->isError())
+		return right;
+
+	Object *res = cc->evaluator.evalCompoundAssignment(node->name, node->operand, right, env);
+
+	if (res->isError())
+		return res;
+
+	return __NULL;
+}
+
+Object *ClosureCompiler::runIndexAssign(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Object *operands[3];
+
+	for (int i = 0; i < 3; i++)
+	{
+		operands[i] = node->children[i]->run(cc, env);
+
+		if (operands[i]->isError())
+			return operands[i];
+	}
+
+	return cc->evaluator.evalIndexAssignment(operands[0], operands[1], operands[2]);
+}
+
+// Expressions
+
+Object *ClosureCompiler::runIntegerLiteral(ClosureCompiler *, CompiledNode *node, Environment *)
+{
+	if (((IntegerLiteral *)node->node)->constant != nullptr)
+		return ((IntegerLiteral *)node->node)->constant;
+
+	return new Integer(node->intValue);
+}
+
+Object *ClosureCompiler::runBooleanLiteral(ClosureCompiler *, CompiledNode *node, Environment *)
+{
+	return node->boolValue ? __TRUE : __FALSE;
+}
+
+Object *ClosureCompiler::runStringLiteral(ClosureCompiler *, CompiledNode *node, Environment *)
+{
+	return new String(node->name);
+}
+
+Object *ClosureCompiler::runNull(ClosureCompiler *, CompiledNode *, Environment *)
+{
+	return __NULL;
+}
+
+Object *ClosureCompiler::runPrefix(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Object *right = node->children[0]->run(cc, env);
+
+	if (right->isError())
+		return right;
+
+	return cc->evaluator.evalPrefixExpression(node->operand, right);
+}
+
+Object *ClosureCompiler::runInfix(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Object *left = node->children[0]->run(cc, env);
+	if (left->isError())
+		return left;
+
+	Object *right = node->children[1]->run(cc, env);
+	if (right->isError())
+		return right;
+
+	if (node->intOp != nullptr && left->type() == INTEGER_OBJ && right->type() == INTEGER_OBJ)
+	{
+		Object *res = node->intOp(((Integer *)left)->value, ((Integer *)right)->value);
+
+		if (res != nullptr)
+			return res;
+	}
+
+	return cc->evaluator.evalInfixExpression(node->operand, left, right);
+}
+
+Object *ClosureCompiler::runIf(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Object *condition = node->children[0]->run(cc, env);
+
+	if (isTruthy(condition))
+		return node->children[1]->run(cc, env);
+
+	else if (node->children.size() > 2)
+		return node->children[2]->run(cc, env);
+
+	return __NULL;
+}
+
+Object *ClosureCompiler::runWhile(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	CompiledNode *condition = node->children[0];
+	CompiledNode *consequence = node->children[1];
+
+	while (true)
+	{
+		Object *cond = condition->run(cc, env);
+
+		if (cond->isError())
+			return cond;
+
+		if (!isTruthy(cond))
+			return __NULL;
+
+		Object *result = consequence->run(cc, env);
+
+		if (result->isError() || cc->returning)
+			return result;
+	}
+}
+
+Object *ClosureCompiler::runIdentifier(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	return cc->evaluator.evalIdentifier((Identifier *)node->node, env);
+}
+
+Object *ClosureCompiler::runFunctionLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	return cc->evaluator.makeClosure((FunctionLiteral *)node->node, env);
+}
+
+Object *ClosureCompiler::runCall(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	return cc->call(node, env, false);
+}
+
+// same as Evaluator::evalCall, a tail call is left in tailCall for callFunction
+Object *ClosureCompiler::call(CompiledNode *node, Environment *env, bool tail)
+{
+	Object *fn = node->children[0]->run(this, env);
+
+	if (fn->isError())
+		return fn;
+
+	size_t argc = node->children.size() - 1;
+	Object *stackArgs[BUILTIN_MAX_ARGS];
+	std::vector<Object *> heapArgs;
+	Object **argv = stackArgs;
+
+	if (argc > BUILTIN_MAX_ARGS)
+	{
+		heapArgs.resize(argc);
+		argv = heapArgs.data();
+	}
+
+	for (size_t i = 0; i < argc; i++)
+	{
+		Object *arg = node->children[i + 1]->run(this, env);
+
+		if (arg->isError())
+			return arg;
+
+		argv[i] = arg;
+	}
+
+	bool builtin;
+	Object *error = evaluator.checkCallee((CallExpression *)node->node, fn, builtin);
+
+	if (error != nullptr)
+		return error;
+
+	if (builtin)
+		return ((Builtin *)fn)->function(Arguments(argv, argc));
+
+	if (tail)
+	{
+		tailCall.call = (CallExpression *)node->node;
+		tailCall.function = (Function *)fn;
+		tailCall.args.assign(argv, argv + argc);
+		returning = true;
+		return __NULL;
+	}
+
+	std::vector<Object *> args(argv, argv + argc);
+
+	return callFunction((Function *)fn, args);
+}
+
+Object *ClosureCompiler::callFunction(Function *function, std::vector<Object *> &args)
+{
+	Environment *extendedEnv = evaluator.extendFunctionEnv(function, args, function->env);
+
+	callDepth++;
+	Object *evaluated = compileBody(function->body)->run(this, extendedEnv);
+	callDepth--;
+
+	while (tailCall.function != nullptr)
+	{
+		function = tailCall.function;
+		tailCall.function = nullptr;
+		returning = false;
+
+		extendedEnv = evaluator.reuseFunctionEnv(function, tailCall.args, extendedEnv);
+
+		callDepth++;
+		evaluated = compileBody(function->body)->run(this, extendedEnv);
+		callDepth--;
+	}
+
+	evaluator.releaseFunctionEnv(extendedEnv);
+	returning = false;
+
+	return evaluated;
+}
+
+Object *ClosureCompiler::runInlinedCall(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	if (cc->evaluator.inlineHolds((InlinedCall *)node->node, env))
+		return node->children[0]->run(cc, env);
+
+	return node->children[1]->run(cc, env);
+}
+
+Object *ClosureCompiler::runArrayLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	std::vector<Object *> elems;
+
+	for (auto element : node->children)
+	{
+		Object *elem = element->run(cc, env);
+
+		if (elem->isError())
+			return elem;
+
+		elems.push_back(elem);
+	}
+
+	return new Array(elems);
+}
+
+Object *ClosureCompiler::runIndex(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Object *array = node->children[0]->run(cc, env);
+
+	if (array->isError())
+		return array;
+
+	Object *index = node->children[1]->run(cc, env);
+
+	if (index->isError())
+		return index;
+
+	return cc->evaluator.evalIndexExpression(array, index, env);
+}
+
+// a third child is the end, without one the slice runs to the end
+Object *ClosureCompiler::runSlice(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Object *values[3] = {nullptr, nullptr, nullptr};
+
+	for (size_t i = 0; i < node->children.size(); i++)
+	{
+		values[i] = node->children[i]->run(cc, env);
+
+		if (values[i]->isError())
+			return values[i];
+	}
+
+	return cc->evaluator.evalSliceExpression(values[0], values[1], values[2]);
+}
+
+Object *ClosureCompiler::runHashMapLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	HashMap *hashMap = new HashMap();
+
+	for (size_t i = 0; i < node->children.size(); i += 2)
+	{
+		Object *key = node->children[i]->run(cc, env);
+
+		if (key->isError())
+			return key;
+
+		Object *value = node->children[i + 1]->run(cc, env);
+
+		if (value->isError())
+		{
+			delete hashMap;
+			return value;
+		}
+
+		hashMap->pairs.set(HashKey(key), key, value);
+	}
+
+	return hashMap;
+}
+
+Object *ClosureCompiler::runHashSetLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	HashSet *hashSet = new HashSet();
+
+	for (auto elem : node->children)
+	{
+		Object *key = elem->run(cc, env);
+
+		if (key->isError())
+		{
+			delete hashSet;
+			return key;
+		}
+
+		hashSet->pairs.set(HashKey(key), key, key);
+	}
+
+	return hashSet;
+}
+
+Object *ClosureCompiler::runStackLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Stack *stack = new Stack();
+
+	for (auto elem : node->children)
+	{
+		Object *obj = elem->run(cc, env);
+
+		if (obj->isError())
+		{
+			delete stack;
+			return obj;
+		}
+
+		stack->elements.push(obj);
+	}
+
+	return stack;
+}
+
+Object *ClosureCompiler::runQueueLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Queue *queue = new Queue();
+
+	for (auto elem : node->children)
+	{
+		Object *obj = elem->run(cc, env);
+
+		if (obj->isError())
+		{
+			delete queue;
+			return obj;
+		}
+
+		queue->elements.push(obj);
+	}
+
+	return queue;
+}
+
+Object *ClosureCompiler::runDequeLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	Deque *deque = new Deque();
+
+	for (auto elem : node->children)
+	{
+		Object *obj = elem->run(cc, env);
+
+		if (obj->isError())
+		{
+			delete deque;
+			return obj;
+		}
+
+		deque->elements.push_back(obj);
+	}
+
+	return deque;
+}
+
+Object *ClosureCompiler::runMaxHeapLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	MaxHeap *maxHeap = new MaxHeap(node->name);
+
+	for (auto elem : node->children)
+	{
+		Object *obj = elem->run(cc, env);
+
+		if (obj->isError())
+		{
+			delete maxHeap;
+			return obj;
+		}
+
+		maxHeap->elements.push(obj);
+	}
+
+	return maxHeap;
+}
+
+Object *ClosureCompiler::runMinHeapLiteral(ClosureCompiler *cc, CompiledNode *node, Environment *env)
+{
+	MinHeap *minHeap = new MinHeap(node->name);
+
+	for (auto elem : node->children)
+	{
+		Object *obj = elem->run(cc, env);
+
+		if (obj->isError())
+		{
+			delete minHeap;
+			return obj;
+		}
+
+		minHeap->elements.push(obj);
+	}
+
+	return minHeap;
+}
@@ -17,22 +17,134 @@ Environment *Environment::NewEnclosed()
 
 Object *Environment::Get(std::string name)
 {
-	if (store.find(name) == store.end())
+	Object *obj = Lookup(name);
+
+	if (obj == nullptr)
+		return new Error(ERROR_IDENTIFIER_NOT_FOUND, name);
+
+	return obj;
+}
+
+Object *Environment::Lookup(const std::string &name)
+{
+	for (Environment *env = this; env != nullptr; env = env->outer)
 	{
-		if (outer != nullptr)
-		{
-			Object *obj = outer->Get(name);
-			return obj;
-		}
+		Object **slot = env->store.find(name);
+
+		if (slot == nullptr)
+			continue;
+
+		if (!(*slot)->isCell())
+			return *slot;
 
-		return new Error("error : identifier not found -> " + name);
+		// an empty cell stands for a binding that does not exist yet
+		if (((Cell *)*slot)->value != nullptr)
+			return ((Cell *)*slot)->value;
 	}
 
-	return store[name];
+	return nullptr;
 }
 
 Object *Environment::Set(std::string name, Object *val)
 {
-	store[name] = val;
+	Object **slot = store.find(name);
+
+	if (slot == nullptr)
+		store.add(name, val);
+	else if ((*slot)->isCell())
+		((Cell *)*slot)->value = val;
+	else
+		*slot = val;
+
 	return val;
-}
\ No newline at end of file
+}
+
+// Cell of name as bound in this environment or an enclosing one below root,
+// boxing the binding in place the first time it is captured. A name not
+// bound yet gets an empty cell here, filled by the let that binds it later.
+Cell *Environment::Capture(const std::string &name, Environment *root)
+{
+	for (Environment *env = this; env != root; env = env->outer)
+	{
+		Object **slot = env->store.find(name);
+
+		if (slot == nullptr)
+			continue;
+
+		if (!(*slot)->isCell())
+			*slot = new Cell(*slot);
+
+		return (Cell *)*slot;
+	}
+
+	Cell *cell = new Cell(nullptr);
+	store.add(name, cell);
+
+	return cell;
+}
+
+Object **Bindings::find(const std::string &name)
+{
+	if (table != nullptr)
+	{
+		auto it = table->find(name);
+		return it == table->end() ? nullptr : &it->second;
+	}
+
+	for (int i = 0; i < count; i++)
+		if (names[i] == name)
+			return &values[i];
+
+	return nullptr;
+}
+
+void Bindings::add(const std::string &name, Object *value)
+{
+	if (table == nullptr && count < ENV_INLINE_BINDINGS)
+	{
+		names[count] = name;
+		values[count] = value;
+		count++;
+
+		return;
+	}
+
+	if (table == nullptr)
+	{
+		table = new std::unordered_map<std::string, Object *>();
+
+		for (int i = 0; i < count; i++)
+			table->emplace(names[i], values[i]);
+
+		count = 0;
+	}
+
+	table->emplace(name, value);
+}
+
+// a pooled frame starts over with the inline arrays, whatever it held before
+void Bindings::clear()
+{
+	count = 0;
+
+	delete table;
+	table = nullptr;
+}
+
+size_t Bindings::size()
+{
+	return table != nullptr ? table->size() : count;
+}
+
+std::vector<std::string> Bindings::keys()
+{
+	if (table == nullptr)
+		return std::vector<std::string>(names, names + count);
+
+	std::vector<std::string> keys;
+
+	for (auto &binding : *table)
+		keys.push_back(binding.first);
+
+	return keys;
+}
@@ -1,5 +1,6 @@
 #include "../header/builtins.hpp"
 #include "../header/evaluator.hpp"
+#include "../header/closure_compiler.hpp"
 
 bool isTruthy(Object *condition)
 {
@@ -31,20 +32,31 @@ Object *Evaluator::Eval(Node *node, Environment *env)
 
 	else if (nodeType == "ReturnStatement")
 	{
-		Object *value = Eval(((ReturnStatement *)node)->returnValue, env);
+		Expression *returnExpr = ((ReturnStatement *)node)->returnValue;
+		Object *value;
 
-		if (value->type() == ERROR_OBJ)
+		if (callDepth > 0 && returnExpr->nodeType() == "CallExpression")
+		{
+			value = evalCall((CallExpression *)returnExpr, env, true);
+
+			if (tailCall.function != nullptr)
+				return value;
+		}
+		else
+			value = Eval(returnExpr, env);
+
+		if (value->isError())
 			return value;
 
-		ReturnValue *returnValue = new ReturnValue(value);
-		return returnValue;
+		returning = true;
+		return value;
 	}
 
 	else if (nodeType == "LetStatement")
 	{
 		Object *value = Eval(((LetStatement *)node)->value, env);
 
-		if (value->type() == ERROR_OBJ)
+		if (value->isError())
 			return value;
 
 		env->Set((((LetStatement *)node)->name).value, value);
@@ -52,22 +64,61 @@ Object *Evaluator::Eval(Node *node, Environment *env)
 
 	else if (nodeType == "AssignStatement")
 	{
+		InfixExpression *compound = ((AssignStatement *)node)->compound();
+
+		if (compound != nullptr)
+		{
+			Object *right = Eval(compound->right, env);
+
+			if (right->isError())
+				return right;
+
+			Object *res = evalCompoundAssignment(((AssignStatement *)node)->name.value, compound->operand, right, env);
+
+			if (res->isError())
+				return res;
+
+			return __NULL;
+		}
+
 		Object *value = Eval(((AssignStatement *)node)->value, env);
 
-		if (value->type() == ERROR_OBJ)
+		if (value->isError())
 			return value;
 
-		Object *obj = env->Get((((AssignStatement *)node)->name).value);
-
-		if (obj->type() == ERROR_OBJ)
-			return obj;
+		if (env->Lookup((((AssignStatement *)node)->name).value) == nullptr)
+			return new Error(ERROR_IDENTIFIER_NOT_FOUND, (((AssignStatement *)node)->name).value);
 
 		env->Set((((AssignStatement *)node)->name).value, value);
 	}
 
+	else if (nodeType == "IndexAssignStatement")
+	{
+		IndexAssignStatement *stmt = (IndexAssignStatement *)node;
+		Object *left = Eval(stmt->target->array, env);
+
+		if (left->isError())
+			return left;
+
+		Object *index = Eval(stmt->target->index, env);
+
+		if (index->isError())
+			return index;
+
+		Object *value = Eval(stmt->value, env);
+
+		if (value->isError())
+			return value;
+
+		return evalIndexAssignment(left, index, value);
+	}
+
 	// Expressions
 	else if (nodeType == "IntegerLiteral")
 	{
+		if (((IntegerLiteral *)node)->constant != nullptr)
+			return ((IntegerLiteral *)node)->constant;
+
 		Integer *integer = new Integer(((IntegerLiteral *)node)->value);
 		return integer;
 	}
@@ -86,7 +137,7 @@ Object *Evaluator::Eval(Node *node, Environment *env)
 	else if (nodeType == "PrefixExpression")
 	{
 		Object *right = Eval(((PrefixExpression *)node)->right, env);
-		if (right->type() == ERROR_OBJ)
+		if (right->isError())
 			return right;
 
 		return evalPrefixExpression(((PrefixExpression *)node)->operand, right);
@@ -95,11 +146,11 @@ Object *Evaluator::Eval(Node *node, Environment *env)
 	else if (nodeType == "InfixExpression")
 	{
 		Object *left = Eval(((InfixExpression *)node)->left, env);
-		if (left->type() == ERROR_OBJ)
+		if (left->isError())
 			return left;
 
 		Object *right = Eval(((InfixExpression *)node)->right, env);
-		if (right->type() == ERROR_OBJ)
+		if (right->isError())
 			return right;
 
 		return evalInfixExpression(((InfixExpression *)node)->operand, left, right);
@@ -109,24 +160,7 @@ Object *Evaluator::Eval(Node *node, Environment *env)
 		return evalIfExpression((IfExpression *)node, env);
 
 	else if (nodeType == "WhileExpression")
-	{
-		while (true)
-		{
-			Object *condition = Eval(((WhileExpression *)node)->condition, env);
-
-			if (condition->type() == ERROR_OBJ)
-				return condition;
-
-			if (!isTruthy(condition))
-				return __NULL;
-
-			Object *result = Eval(((WhileExpression *)node)->consequence, env);
-
-			if (result->type() == ERROR_OBJ ||
-				result->type() == RETURN_VALUE_OBJ)
-				return result;
-		}
-	}
+		return evalWhileExpression((WhileExpression *)node, env);
 
 	else if (nodeType == "Identifier")
 	{
@@ -134,32 +168,19 @@ Object *Evaluator::Eval(Node *node, Environment *env)
 	}
 
 	else if (nodeType == "FunctionLiteral")
-	{
-		Object *fn = new Function(((FunctionLiteral *)node)->parameters, ((FunctionLiteral *)node)->body, env);
-
-		return fn;
-	}
+		return makeClosure((FunctionLiteral *)node, env);
 
 	else if (nodeType == "CallExpression")
-	{
-		Object *fn = Eval(((CallExpression *)node)->function, env);
+		return evalCall((CallExpression *)node, env, false);
 
-		if (fn->type() == ERROR_OBJ)
-			return fn;
-
-		std::vector<Object *> args;
-
-		for (auto *argument : ((CallExpression *)node)->arguments)
-		{
-			Object *arg = Eval(argument, env);
-
-			if (arg->type() == ERROR_OBJ)
-				return arg;
+	else if (nodeType == "InlinedCall")
+	{
+		InlinedCall *inlined = (InlinedCall *)node;
 
-			args.push_back(arg);
-		}
+		if (inlineHolds(inlined, env))
+			return Eval(inlined->expression, env);
 
-		return evalCallExpression(fn, args);
+		return evalCall(inlined->call, env, false);
 	}
 
 	else if (nodeType == "ArrayLiteral")
@@ -170,7 +191,7 @@ Object *Evaluator::Eval(Node *node, Environment *env)
 		{
 			Object *elem = Eval(element, env);
 
-			if (elem->type() == ERROR_OBJ)
+			if (elem->isError())
 				return elem;
 
 			elems.push_back(elem);
@@ -183,17 +204,43 @@ Object *Evaluator::Eval(Node *node, Environment *env)
 	{
 		Object *array = Eval(((IndexExpression *)node)->array, env);
 
-		if (array->type() == ERROR_OBJ)
+		if (array->isError())
 			return array;
 
 		Object *index = Eval(((IndexExpression *)node)->index, env);
 
-		if (index->type() == ERROR_OBJ)
+		if (index->isError())
 			return index;
 
 		return evalIndexExpression(array, index, env);
 	}
 
+	else if (nodeType == "SliceExpression")
+	{
+		SliceExpression *slice = (SliceExpression *)node;
+		Object *array = Eval(slice->array, env);
+
+		if (array->isError())
+			return array;
+
+		Object *start = Eval(slice->start, env);
+
+		if (start->isError())
+			return start;
+
+		Object *end = nullptr;
+
+		if (slice->end != nullptr)
+		{
+			end = Eval(slice->end, env);
+
+			if (end->isError())
+				return end;
+		}
+
+		return evalSliceExpression(array, start, end);
+	}
+
 	else if (nodeType == "HashMapLiteral")
 		return evalHashMapLiteral((HashMapLiteral *)node, env);
 
@@ -220,16 +267,19 @@ Object *Evaluator::Eval(Node *node, Environment *env)
 
 Object *Evaluator::evalProgram(Program *program, Environment *env)
 {
-	Object *result;
+	Object *result = __NULL;
 
 	for (Statement *stmt : program->statements)
 	{
 		result = Eval(stmt, env);
 
-		if (result->type() == RETURN_VALUE_OBJ || result->type() == ERROR_OBJ)
-			return ((ReturnValue *)result)->value;
+		if (returning)
+		{
+			returning = false;
+			return result;
+		}
 
-		else if (result->type() == ERROR_OBJ)
+		else if (result->isError())
 			return result;
 	}
 
@@ -238,13 +288,13 @@ Object *Evaluator::evalProgram(Program *program, Environment *env)
 
 Object *Evaluator::evalBlockStatement(BlockStatement *blockStmt, Environment *env)
 {
-	Object *result;
+	Object *result = __NULL;
 
 	for (Statement *stmt : blockStmt->statements)
 	{
 		result = Eval(stmt, env);
-		if (result->type() == "RETURN_VALUE" || result->type() == "ERROR")
-			return (ReturnValue *)result;
+		if (returning || result->isError())
+			return result;
 	}
 
 	return result;
@@ -368,13 +418,10 @@ Object *Evaluator::evalIntegerInfixExpression(std::string operand, Object *left,
 
 Object *Evaluator::evalStringInfixExpression(std::string operand, Object *left, Object *right)
 {
-	std::string leftVal = ((String *)left)->value;
-	std::string rightVal = ((String *)right)->value;
-
 	Object *res;
 
 	if (operand == "+")
-		res = new String(leftVal + rightVal);
+		res = new String((String *)left, (String *)right);
 	else
 		return new Error("error: unknown operator -> " + left->type() + " " + operand + " " + right->type());
 
@@ -394,43 +441,318 @@ Object *Evaluator::evalIfExpression(IfExpression *ifExpr, Environment *env)
 	return __NULL;
 }
 
+Object *Evaluator::evalWhileExpression(WhileExpression *whileExpr, Environment *env)
+{
+	while (true)
+	{
+		Object *condition = Eval(whileExpr->condition, env);
+
+		if (condition->isError())
+			return condition;
+
+		if (!isTruthy(condition))
+			return __NULL;
+
+		Object *result = Eval(whileExpr->consequence, env);
+
+		if (result->isError() || returning)
+			return result;
+
+		// back-edge
+		if (osrThreshold > 0 && ++whileExpr->hotness >= osrThreshold)
+			return evalOsr(whileExpr, env);
+	}
+}
+
+void Evaluator::EnableOsr(int threshold)
+{
+	osrThreshold = threshold;
+
+	if (osrCompiler == nullptr)
+		osrCompiler = new ClosureCompiler();
+}
+
+// Finishes a hot loop in a faster tier. Its live variables are all in env: the
+// JIT copies them into native slots and writes them back, the closure tier
+// keeps running on env directly and also takes over whatever the JIT bails on.
+Object *Evaluator::evalOsr(WhileExpression *whileExpr, Environment *env)
+{
+	if (jit != nullptr && !whileExpr->jitFailed)
+	{
+		if (whileExpr->jitted == nullptr)
+		{
+			whileExpr->jitted = jit->CompileLoop(whileExpr, env);
+			whileExpr->jitFailed = whileExpr->jitted == nullptr;
+		}
+
+		if (whileExpr->jitted != nullptr && jit->RunLoop(whileExpr->jitted, env) == JIT_LOOP_DONE)
+			return __NULL;
+	}
+
+	if (whileExpr->compiled == nullptr)
+		whileExpr->compiled = osrCompiler->Compile(whileExpr);
+
+	Object *result = osrCompiler->Run(whileExpr->compiled, env);
+
+	// a return inside the loop goes on unwinding in this tier
+	returning = osrCompiler->returning;
+	osrCompiler->returning = false;
+
+	return result;
+}
+
 Object *Evaluator::evalIdentifier(Identifier *ident, Environment *env)
 {
-	Object *obj = env->Get(ident->value);
+	if (ident->builtin != nullptr)
+		return ident->builtin;
+
+	// a captured variable is read from its cell in the closure's environment,
+	// which the frame of the call is enclosed in. An empty cell is a binding
+	// that does not exist yet, looked up like any other name.
+	Object *obj = ident->capture >= 0 ? env->outer->cells[ident->capture]->value : nullptr;
 
-	if (obj->type() != ERROR_OBJ &&
-		builtin.find(ident->value) != builtin.end())
-		return builtin[ident->value];
+	if (obj == nullptr)
+		obj = env->Lookup(ident->value);
+
+	if (obj != nullptr)
+	{
+		if (obj->isString())
+			((String *)obj)->unique = false;
 
-	return obj;
+		return obj;
+	}
+
+	auto it = builtin.find(ident->value);
+
+	if (it != builtin.end())
+		return it->second;
+
+	return new Error(ERROR_IDENTIFIER_NOT_FOUND, ident->value);
 }
 
-Object *Evaluator::evalCallExpression(Object *fn, std::vector<Object *> &args)
+// Evaluates callee and arguments of a call. In tail position a call to a mod
+// function is not made here but left in tailCall for applyFunction.
+Object *Evaluator::evalCall(CallExpression *call, Environment *env, bool tail)
 {
-	if (fn->type() != FUNCTION_OBJ && fn->type() != BUILTIN_OBJ)
-		return new Error("error: not a function -> " + fn->type());
+	Object *fn = Eval(call->function, env);
 
-	if (fn->type() == BUILTIN_OBJ)
-		return ((Builtin *)fn)->function(args);
+	if (fn->isError())
+		return fn;
 
-	if (((Function *)fn)->parameters.size() != args.size())
-		return new Error(
-			"error: argument length (" + std::to_string(args.size()) +
-			") not equal to parameter length (" + std::to_string(((Function *)fn)->parameters.size()) + ")");
+	// arguments go to a native stack array, a vector is only built for mod functions
+	size_t argc = call->arguments.size();
+	Object *stackArgs[BUILTIN_MAX_ARGS];
+	std::vector<Object *> heapArgs;
+	Object **argv = stackArgs;
 
-	Environment *extendedEnv = extendFunctionEnv((Function *)fn, args, ((Function *)fn)->env);
+	if (argc > BUILTIN_MAX_ARGS)
+	{
+		heapArgs.resize(argc);
+		argv = heapArgs.data();
+	}
 
-	Object *evaluated = Eval(((Function *)fn)->body, extendedEnv);
+	for (size_t i = 0; i < argc; i++)
+	{
+		Object *arg = Eval(call->arguments[i], env);
+
+		if (arg->isError())
+			return arg;
+
+		argv[i] = arg;
+	}
+
+	bool builtin;
+	Object *error = checkCallee(call, fn, builtin);
+
+	if (error != nullptr)
+		return error;
 
-	if (evaluated->type() == RETURN_VALUE_OBJ)
-		return ((ReturnValue *)evaluated)->value;
+	if (builtin)
+		return ((Builtin *)fn)->function(Arguments(argv, argc));
+
+	if (tail)
+	{
+		tailCall.call = call;
+		tailCall.function = (Function *)fn;
+		tailCall.args.assign(argv, argv + argc);
+		returning = true;
+		return __NULL;
+	}
+
+	std::vector<Object *> args(argv, argv + argc);
+
+	if (jit != nullptr)
+	{
+		Object *result = evalJitCall(call, (Function *)fn, args);
+
+		if (result != nullptr)
+			return result;
+	}
+
+	return applyFunction((Function *)fn, args);
+}
+
+// Whether the name an inlined call goes through still refers to the function
+// that was inlined. Any closure of the same function literal does, the body
+// only depends on the parameters.
+bool Evaluator::inlineHolds(InlinedCall *inlined, Environment *env)
+{
+	Object *fn = evalIdentifier((Identifier *)inlined->call->function, env);
+
+	if (fn == inlined->verified)
+		return true;
+
+	if (fn->type() != FUNCTION_OBJ || ((Function *)fn)->body != inlined->body)
+		return false;
+
+	inlined->verified = fn;
+	return true;
+}
+
+// Checks that fn can be called with the arguments of call. Callees that passed
+// before are found in the call site's inline cache and skip the type and arity
+// checks. Returns the Error if fn cannot be called, nullptr otherwise.
+Object *Evaluator::checkCallee(CallExpression *call, Object *fn, bool &builtin)
+{
+	for (int i = 0; i < call->cached; i++)
+	{
+		if (call->cache[i].callee == fn)
+		{
+			builtin = call->cache[i].builtin;
+			return nullptr;
+		}
+	}
+
+	ObjectType type = fn->type();
+
+	if (type != FUNCTION_OBJ && type != BUILTIN_OBJ)
+		return new Error(ERROR_NOT_A_FUNCTION, type);
+
+	builtin = type == BUILTIN_OBJ;
+	int arity = builtin ? ((Builtin *)fn)->arity : ((Function *)fn)->parameters.size();
+
+	if (arity != BUILTIN_VARIADIC && arity != call->arguments.size())
+		return new Error(ERROR_ARGUMENT_LENGTH, call->arguments.size(), arity);
+
+	// a megamorphic site keeps its first callees, the others are checked every call
+	if (call->cached < CALL_CACHE_SIZE)
+	{
+		call->cache[call->cached].callee = fn;
+		call->cache[call->cached].builtin = builtin;
+		call->cached++;
+	}
+
+	return nullptr;
+}
+
+// Runs the body of a function already checked to take args
+Object *Evaluator::applyFunction(Function *fn, std::vector<Object *> &args)
+{
+	Environment *extendedEnv = extendFunctionEnv(fn, args, fn->env);
+
+	callDepth++;
+	Object *evaluated = Eval(fn->body, extendedEnv);
+	callDepth--;
+
+	// trampoline: tail calls run here one after the other instead of nesting,
+	// so tail recursion takes constant native stack. Their callees went
+	// through checkCallee when the tail call was set up.
+	while (tailCall.function != nullptr)
+	{
+		fn = tailCall.function;
+		tailCall.function = nullptr;
+		returning = false;
+
+		if (jit != nullptr)
+		{
+			Object *result = evalJitCall(tailCall.call, fn, tailCall.args);
+
+			if (result != nullptr)
+			{
+				releaseFunctionEnv(extendedEnv);
+				return result;
+			}
+		}
+
+		// the returning frame is dead, closures created in it only kept cells
+		extendedEnv = reuseFunctionEnv(fn, tailCall.args, extendedEnv);
+
+		callDepth++;
+		evaluated = Eval(fn->body, extendedEnv);
+		callDepth--;
+	}
+
+	releaseFunctionEnv(extendedEnv);
+	returning = false;
 
 	return evaluated;
 }
 
+// Counts calls of a function body and runs its native code once it got hot.
+// Returns nullptr whenever the call has to go through the interpreter instead.
+Object *Evaluator::evalJitCall(CallExpression *call, Function *fn, std::vector<Object *> &args)
+{
+	BlockStatement *body = fn->body;
+
+	if (body->jitted == nullptr)
+	{
+		if (body->jitFailed || ++body->hotness < jit->HotThreshold())
+			return nullptr;
+
+		std::string selfName;
+		if (call->function->nodeType() == "Identifier")
+			selfName = ((Identifier *)call->function)->value;
+
+		body->jitted = jit->Compile(fn, selfName, args);
+		body->jitFailed = body->jitted == nullptr;
+
+		if (body->jitFailed)
+			return nullptr;
+	}
+
+	return jit->Call(body->jitted, fn, args);
+}
+
+// A function created inside a call keeps the variables it uses from enclosing
+// frames as cells in an environment of its own, directly below the global one,
+// instead of the whole chain of frames
+Object *Evaluator::makeClosure(FunctionLiteral *literal, Environment *env)
+{
+	std::vector<std::string> &captures = literal->Captures();
+
+	if (env->outer == nullptr)
+		return new Function(literal->parameters, literal->body, env);
+
+	Environment *root = env;
+	while (root->outer != nullptr)
+		root = root->outer;
+
+	Environment *closureEnv = root->NewEnclosed();
+
+	for (auto &name : captures)
+	{
+		Cell *cell = env->Capture(name, root);
+
+		closureEnv->store.add(name, cell);
+		closureEnv->cells.push_back(cell);
+	}
+
+	return new Function(literal->parameters, literal->body, closureEnv);
+}
+
+// Frames come from the pool when one is free, see releaseFunctionEnv
 Environment *Evaluator::extendFunctionEnv(Function *fn, std::vector<Object *> &args, Environment *outer)
 {
-	Environment *env = outer->NewEnclosed();
+	Environment *env;
+
+	if (framePool.empty())
+		env = outer->NewEnclosed();
+	else
+	{
+		env = framePool.back();
+		framePool.pop_back();
+		env->outer = outer;
+	}
 
 	for (int i = 0; i < args.size(); i++)
 		env->Set(fn->parameters[i]->value, args[i]);
@@ -438,6 +760,29 @@ Environment *Evaluator::extendFunctionEnv(Function *fn, std::vector<Object *> &a
 	return env;
 }
 
+// Rebinds a frame nothing refers to anymore for the next call of a tail call
+// chain, so tail recursion runs in constant memory as well
+Environment *Evaluator::reuseFunctionEnv(Function *fn, std::vector<Object *> &args, Environment *frame)
+{
+	frame->store.clear();
+	frame->outer = fn->env;
+
+	for (int i = 0; i < args.size(); i++)
+		frame->Set(fn->parameters[i]->value, args[i]);
+
+	return frame;
+}
+
+// Returns the frame of a finished call to the pool. Nothing keeps a reference
+// to it, closures created during the call only kept the cells of the variables
+// they use. The store keeps its inline slots, so the next call binds its
+// parameters without allocating.
+void Evaluator::releaseFunctionEnv(Environment *frame)
+{
+	frame->store.clear();
+	framePool.push_back(frame);
+}
+
 Object *Evaluator::evalIndexExpression(Object *left, Object *index, Environment *env)
 {
 	if (left->type() == STRING_OBJ && index->type() == INTEGER_OBJ)
@@ -449,30 +794,123 @@ Object *Evaluator::evalIndexExpression(Object *left, Object *index, Environment
 	else if (left->type() == HASHMAP_OBJ)
 		return evalHashMapIndexExpression((HashMap *)left, index);
 
+	else if (left->type() == DEQUE_OBJ && index->type() == INTEGER_OBJ)
+	{
+		std::deque<Object *> &elements = ((Deque *)left)->elements;
+		int i = ((Integer *)index)->value;
+
+		if (i < 0 || elements.size() <= i)
+			return new Error(ERROR_INDEX_OUT_OF_RANGE, i);
+
+		return elements[i];
+	}
+
 	else
 		return new Error("error: index operator [] not supported for -> " + left->type());
 }
 
+// `left[index] = value`, the container is changed in place
+Object *Evaluator::evalIndexAssignment(Object *left, Object *index, Object *value)
+{
+	ObjectType type = left->type();
+
+	if (type == HASHMAP_OBJ)
+	{
+		((HashMap *)left)->pairs.set(HashKey(index), index, value);
+		return __NULL;
+	}
+
+	if ((type != ARRAY_OBJ && type != DEQUE_OBJ) || index->type() != INTEGER_OBJ)
+		return new Error("error: index assignment not supported for -> " + type + "[" + index->type() + "]");
+
+	int i = ((Integer *)index)->value;
+	size_t size = type == ARRAY_OBJ ? ((Array *)left)->size() : ((Deque *)left)->elements.size();
+
+	if (i < 0 || size <= i)
+		return new Error(ERROR_INDEX_OUT_OF_RANGE, i);
+
+	if (type == ARRAY_OBJ)
+		((Array *)left)->set(i, value);
+	else
+		((Deque *)left)->elements[i] = value;
+
+	return __NULL;
+}
+
+// `name op= right`, right already evaluated. Appending to a string the
+// previous `+=` made reuses its buffer, so building a string piece by piece
+// in a loop is linear instead of copying everything built so far each time.
+Object *Evaluator::evalCompoundAssignment(const std::string &name, const std::string &op, Object *right, Environment *env)
+{
+	Object *current = env->Lookup(name);
+
+	if (current == nullptr)
+		return new Error(ERROR_IDENTIFIER_NOT_FOUND, name);
+
+	bool strings = op == "+" && current->isString() && right->isString();
+
+	if (strings && ((String *)current)->unique)
+	{
+		((String *)current)->append(((String *)right)->value());
+		return current;
+	}
+
+	Object *value = evalInfixExpression(op, current, right);
+
+	if (value->isError())
+		return value;
+
+	// a new string nothing else has seen yet
+	if (strings)
+		((String *)value)->unique = true;
+
+	env->Set(name, value);
+
+	return value;
+}
+
+// end is nullptr for the rest of the string or array. The slice shares the
+// characters or elements it was taken from, neither is copied here.
+Object *Evaluator::evalSliceExpression(Object *left, Object *start, Object *end)
+{
+	ObjectType type = left->type();
+
+	if ((type != STRING_OBJ && type != ARRAY_OBJ) || start->type() != INTEGER_OBJ ||
+		(end != nullptr && end->type() != INTEGER_OBJ))
+		return new Error("error: slice not supported for -> " + type + "[" + start->type() + ":" +
+						 (end != nullptr ? end->type() : "") + "]");
+
+	int size = type == STRING_OBJ ? ((String *)left)->length() : ((Array *)left)->size();
+	int from = ((Integer *)start)->value;
+	int to = end != nullptr ? ((Integer *)end)->value : size;
+
+	if (from < 0 || from > to || to > size)
+		return new Error(ERROR_SLICE_OUT_OF_RANGE, from, to);
+
+	if (type == STRING_OBJ)
+		return new String((String *)left, from, to);
+
+	return new Array((Array *)left, from, to);
+}
+
 Object *Evaluator::evalArrayIndexExpression(Array *array, Integer *index)
 {
 	int i = index->value;
-	auto arr = array->elements;
 
-	if (arr.size() <= i)
-		return new Error("error: index " + index->inspect() + " out of range");
+	if (array->size() <= i)
+		return new Error(ERROR_INDEX_OUT_OF_RANGE, i);
 
-	return arr[i];
+	return array->at(i);
 }
 
 Object *Evaluator::evalStringIndexExpression(String *string, Integer *index)
 {
 	int i = index->value;
-	auto arr = string->value;
 
-	if (arr.size() <= i)
-		return new Error("error: index " + index->inspect() + " out of range");
+	if (string->length() <= i)
+		return new Error(ERROR_INDEX_OUT_OF_RANGE, i);
 
-	return new String(std::string(1, arr[i]));
+	return new String(std::string(1, string->at(i)));
 }
 
 Object *Evaluator::evalHashMapLiteral(HashMapLiteral *hashMapLiteral, Environment *env)
@@ -483,21 +921,18 @@ Object *Evaluator::evalHashMapLiteral(HashMapLiteral *hashMapLiteral, Environmen
 	{
 		Object *key = Eval(pair.key, env);
 
-		if (key->type() == ERROR_OBJ)
+		if (key->isError())
 			return key;
 
 		Object *value = Eval(pair.value, env);
 
-		if (value->type() == ERROR_OBJ)
+		if (value->isError())
 		{
 			delete hashMap;
 			return value;
 		}
 
-		HashKey hashKey(key->type(), key->inspect());
-		HashMapPairObj hashMapPairObj(key, value);
-
-		hashMap->pairs[hashKey] = hashMapPairObj;
+		hashMap->pairs.set(HashKey(key), key, value);
 	}
 
 	return hashMap;
@@ -505,10 +940,10 @@ Object *Evaluator::evalHashMapLiteral(HashMapLiteral *hashMapLiteral, Environmen
 
 Object *Evaluator::evalHashMapIndexExpression(HashMap *hashMap, Object *index)
 {
-	HashKey hashKey(index->type(), index->inspect());
+	HashEntry *entry = hashMap->pairs.find(HashKey(index));
 
-	if (hashMap->pairs.find(hashKey) != hashMap->pairs.end())
-		return hashMap->pairs[hashKey].value;
+	if (entry != nullptr)
+		return entry->value;
 
 	return new Error("error: key not present -> " + index->inspect());
 }
@@ -521,14 +956,13 @@ Object *Evaluator::evalHashSetLiteral(HashSetLiteral *hashSetLiteral, Environmen
 	{
 		Object *key = Eval(pair, env);
 
-		if (key->type() == ERROR_OBJ)
+		if (key->isError())
 		{
 			delete hashSet;
 			return key;
 		}
 
-		HashKey hashKey(key->type(), key->inspect());
-		hashSet->pairs[hashKey] = key;
+		hashSet->pairs.set(HashKey(key), key, key);
 	}
 
 	return hashSet;
@@ -542,7 +976,7 @@ Object *Evaluator::evalStackLiteral(StackLiteral *stackLiteral, Environment *env
 	{
 		Object *obj = Eval(elem, env);
 
-		if (obj->type() == ERROR_OBJ)
+		if (obj->isError())
 		{
 			delete stack;
 			return obj;
@@ -562,7 +996,7 @@ Object *Evaluator::evalQueueLiteral(QueueLiteral *queueLiteral, Environment *env
 	{
 		Object *obj = Eval(elem, env);
 
-		if (obj->type() == ERROR_OBJ)
+		if (obj->isError())
 		{
 			delete queue;
 			return obj;
@@ -582,7 +1016,7 @@ Object *Evaluator::evalDequeLiteral(DequeLiteral *queueLiteral, Environment *env
 	{
 		Object *obj = Eval(elem, env);
 
-		if (obj->type() == ERROR_OBJ)
+		if (obj->isError())
 		{
 			delete deque;
 			return obj;
@@ -602,7 +1036,7 @@ Object *Evaluator::evalMaxHeapLiteral(MaxHeapLiteral *maxHeapLiteral, Environmen
 	{
 		Object *obj = Eval(elem, env);
 
-		if (obj->type() == ERROR_OBJ)
+		if (obj->isError())
 		{
 			delete maxHeap;
 			return obj;
@@ -622,7 +1056,7 @@ Object *Evaluator::evalMinHeapLiteral(MinHeapLiteral *minHeapLiteral, Environmen
 	{
 		Object *obj = Eval(elem, env);
 
-		if (obj->type() == ERROR_OBJ)
+		if (obj->isError())
 		{
 			delete minHeap;
 			return obj;
@@ -0,0 +1,351 @@
+#include "../header/hash_table.hpp"
+#include "../header/object.hpp"
+
+#ifdef MOD_HASH_TABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Spreads key hashes over all bits, integer keys hash to themselves and would
+// otherwise all land in the first slots with the same control byte
+size_t HashTable::mix(size_t hash)
+{
+	uint64_t mixed = hash;
+
+	mixed ^= mixed >> 33;
+	mixed *= 0xff51afd7ed558ccdULL;
+	mixed ^= mixed >> 33;
+
+	return mixed;
+}
+
+// bit i is set when group[i] == byte
+uint32_t HashTable::matchByte(const int8_t *group, int8_t byte)
+{
+#ifdef MOD_HASH_TABLE_SSE2
+	__m128i bytes = _mm_loadu_si128((const __m128i *)group);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(byte)));
+#else
+	uint32_t bits = 0;
+
+	for (int i = 0; i < HASH_TABLE_GROUP; i++)
+		if (group[i] == byte)
+			bits |= 1u << i;
+
+	return bits;
+#endif
+}
+
+// bit i is set when group[i] is empty, the only control byte with its sign bit set
+uint32_t HashTable::matchEmpty(const int8_t *group)
+{
+#ifdef MOD_HASH_TABLE_SSE2
+	return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+	uint32_t bits = 0;
+
+	for (int i = 0; i < HASH_TABLE_GROUP; i++)
+		if (group[i] < 0)
+			bits |= 1u << i;
+
+	return bits;
+#endif
+}
+
+// whether a table of count entries can index key directly
+bool HashTable::denseKey(const HashKey &key, size_t count)
+{
+	return key.kind == HASH_KEY_INTEGER && key.number >= 0 &&
+		   (size_t)key.number < 2 * count + HASH_TABLE_MIN_CAPACITY;
+}
+
+void HashTable::setSlot(size_t slot, int8_t byte, uint32_t entry)
+{
+	ctrl[slot] = byte;
+	slots[slot] = entry;
+
+	// a group starting near the end reads on into the mirrored bytes
+	if (slot < HASH_TABLE_GROUP)
+		ctrl[capacity() + slot] = byte;
+}
+
+size_t HashTable::lookup(const HashKey &key, size_t hash)
+{
+	int8_t h2 = hash & 0x7f;
+
+	for (size_t pos = (hash >> 7) & mask;; pos = (pos + HASH_TABLE_GROUP) & mask)
+	{
+		const int8_t *group = &ctrl[pos];
+
+		for (uint32_t bits = matchByte(group, h2); bits != 0; bits &= bits - 1)
+		{
+			size_t slot = (pos + __builtin_ctz(bits)) & mask;
+			HashEntry &entry = entries[slots[slot]];
+
+			if (entry.hash == hash && key.matches(entry.key))
+				return slot;
+		}
+
+		// linear probing leaves no gaps, the key would have been before the first empty slot
+		if (matchEmpty(group) != 0)
+			return HASH_TABLE_NOT_FOUND;
+	}
+}
+
+size_t HashTable::position(const HashKey &key, size_t hash)
+{
+	if (count == 0)
+		return HASH_TABLE_NOT_FOUND;
+
+	switch (mode)
+	{
+	case HASH_TABLE_SMALL:
+		for (size_t i = 0; i < entries.size(); i++)
+			if (entries[i].hash == hash && key.matches(entries[i].key))
+				return i;
+
+		return HASH_TABLE_NOT_FOUND;
+
+	case HASH_TABLE_DENSE:
+		if (key.kind != HASH_KEY_INTEGER || key.number < 0 || (size_t)key.number >= direct.size() ||
+			direct[key.number] == 0)
+			return HASH_TABLE_NOT_FOUND;
+
+		return direct[key.number] - 1;
+
+	default:
+	{
+		size_t slot = lookup(key, hash);
+		return slot == HASH_TABLE_NOT_FOUND ? HASH_TABLE_NOT_FOUND : slots[slot];
+	}
+	}
+}
+
+// indexes entries[entry] in the first empty slot of its probe sequence
+void HashTable::place(uint32_t entry)
+{
+	size_t hash = entries[entry].hash;
+
+	for (size_t pos = (hash >> 7) & mask;; pos = (pos + HASH_TABLE_GROUP) & mask)
+	{
+		uint32_t empty = matchEmpty(&ctrl[pos]);
+
+		if (empty != 0)
+		{
+			setSlot((pos + __builtin_ctz(empty)) & mask, hash & 0x7f, entry);
+			return;
+		}
+	}
+}
+
+// Strings change in place through push, pop and +=, so an entry keeps its own
+// String for a string key. It shares the text of the caller's string, which is
+// only copied if that string is changed later.
+Object *HashTable::storedKey(Object *keyObj)
+{
+	if (!keyObj->isString())
+		return keyObj;
+
+	return new String((String *)keyObj);
+}
+
+void HashTable::add(const HashKey &key, Object *keyObj, Object *value, size_t hash)
+{
+	if (mode == HASH_TABLE_SMALL && entries.size() == HASH_TABLE_SMALL_SIZE)
+	{
+		bool dense = denseKey(key, count);
+
+		for (size_t i = 0; dense && i < entries.size(); i++)
+			dense = denseKey(HashKey(entries[i].key), count);
+
+		rebuild(dense ? HASH_TABLE_DENSE : HASH_TABLE_HASHED, 0);
+	}
+
+	else if (mode == HASH_TABLE_DENSE && !denseKey(key, count))
+		rebuild(HASH_TABLE_HASHED, 0);
+
+	// erased entries still take room in the dense array, the hash index is
+	// only made larger if the live ones need it and just compacted otherwise
+	else if (mode == HASH_TABLE_HASHED && (entries.size() + 1) * 4 > capacity() * 3)
+		rebuild(HASH_TABLE_HASHED, capacity());
+
+	else if (mode == HASH_TABLE_DENSE && entries.size() > 2 * count + HASH_TABLE_MIN_CAPACITY)
+		rebuild(HASH_TABLE_DENSE, 0);
+
+	HashEntry entry;
+	entry.key = storedKey(keyObj);
+	entry.value = value == keyObj ? entry.key : value; // a hashset's key is its value too
+	entry.hash = hash;
+
+	entries.push_back(entry);
+	count++;
+
+	if (mode == HASH_TABLE_DENSE)
+	{
+		if ((size_t)key.number >= direct.size())
+			direct.resize(std::max((size_t)key.number + 1, direct.size() * 2), 0);
+
+		direct[key.number] = entries.size();
+	}
+
+	else if (mode == HASH_TABLE_HASHED)
+		place(entries.size() - 1);
+}
+
+// drops the holes erased entries left, the index has to be rebuilt afterwards
+void HashTable::compact()
+{
+	size_t live = 0;
+
+	for (size_t i = 0; i < entries.size(); i++)
+		if (entries[i].key != nullptr)
+			entries[live++] = entries[i];
+
+	entries.resize(live);
+}
+
+void HashTable::rebuild(HashTableMode newMode, size_t newCapacity)
+{
+	compact();
+	mode = newMode;
+
+	if (mode == HASH_TABLE_DENSE)
+	{
+		size_t size = 2 * count + HASH_TABLE_MIN_CAPACITY;
+
+		// keys were dense when added, there may be fewer of them by now
+		for (size_t i = 0; i < entries.size(); i++)
+			size = std::max(size, (size_t)((Integer *)entries[i].key)->value + 1);
+
+		direct.assign(size, 0);
+
+		for (size_t i = 0; i < entries.size(); i++)
+			direct[((Integer *)entries[i].key)->value] = i + 1;
+
+		return;
+	}
+
+	std::vector<uint32_t>().swap(direct);
+
+	if (newCapacity < HASH_TABLE_MIN_CAPACITY)
+		newCapacity = HASH_TABLE_MIN_CAPACITY;
+
+	while ((count + 1) * 2 > newCapacity)
+		newCapacity *= 2;
+
+	entries.reserve(newCapacity * 3 / 4);
+
+	slots.assign(newCapacity, 0);
+	ctrl.assign(newCapacity + HASH_TABLE_GROUP, HASH_TABLE_EMPTY);
+	mask = newCapacity - 1;
+
+	for (size_t i = 0; i < entries.size(); i++)
+		place(i);
+}
+
+HashEntry *HashTable::find(const HashKey &key)
+{
+	size_t found = position(key, mix(key.hash));
+
+	if (found == HASH_TABLE_NOT_FOUND)
+		return nullptr;
+
+	return &entries[found];
+}
+
+bool HashTable::insert(const HashKey &key, Object *keyObj, Object *value)
+{
+	size_t hash = mix(key.hash);
+
+	if (position(key, hash) != HASH_TABLE_NOT_FOUND)
+		return false;
+
+	add(key, keyObj, value, hash);
+	return true;
+}
+
+void HashTable::set(const HashKey &key, Object *keyObj, Object *value)
+{
+	size_t hash = mix(key.hash);
+	size_t found = position(key, hash);
+
+	if (found == HASH_TABLE_NOT_FOUND)
+		add(key, keyObj, value, hash);
+	else // the stored key is equal to keyObj, only the value changes
+		entries[found].value = value == keyObj ? entries[found].key : value;
+}
+
+bool HashTable::erase(const HashKey &key)
+{
+	size_t hash = mix(key.hash);
+
+	if (mode == HASH_TABLE_SMALL)
+	{
+		size_t found = position(key, hash);
+
+		if (found == HASH_TABLE_NOT_FOUND)
+			return false;
+
+		entries.erase(entries.begin() + found);
+		count--;
+
+		return true;
+	}
+
+	if (mode == HASH_TABLE_DENSE)
+	{
+		size_t found = position(key, hash);
+
+		if (found == HASH_TABLE_NOT_FOUND)
+			return false;
+
+		direct[key.number] = 0;
+		entries[found].key = nullptr;
+	}
+
+	else
+	{
+		size_t hole = count == 0 ? HASH_TABLE_NOT_FOUND : lookup(key, hash);
+
+		if (hole == HASH_TABLE_NOT_FOUND)
+			return false;
+
+		entries[slots[hole]].key = nullptr;
+
+		// backward shift: every following slot of the run that may live in the
+		// hole moves into it, leaving the hole at the end of the run
+		for (size_t next = (hole + 1) & mask; ctrl[next] != HASH_TABLE_EMPTY; next = (next + 1) & mask)
+		{
+			size_t home = (entries[slots[next]].hash >> 7) & mask;
+
+			if (((next - home) & mask) >= ((next - hole) & mask))
+			{
+				setSlot(hole, ctrl[next], slots[next]);
+				hole = next;
+			}
+		}
+
+		setSlot(hole, HASH_TABLE_EMPTY, 0);
+	}
+
+	count--;
+
+	// erased entries at the end can go for good, nothing comes after them
+	while (!entries.empty() && entries.back().key == nullptr)
+		entries.pop_back();
+
+	return true;
+}
+
+void HashTable::iterator::skipErased()
+{
+	while (entry < table->entries.size() && table->entries[entry].key == nullptr)
+		entry++;
+}
+
+HashTable::iterator &HashTable::iterator::operator++()
+{
+	entry++;
+	skipErased();
+
+	return *this;
+}
@@ -0,0 +1,1212 @@
+#include "../header/jit.hpp"
+
+#include <string.h>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef MOD_JIT_SUPPORTED
+#include <sys/mman.h>
+#endif
+
+bool Jit::Supported()
+{
+#ifdef MOD_JIT_SUPPORTED
+	return true;
+#else
+	return false;
+#endif
+}
+
+#ifdef MOD_JIT_SUPPORTED
+
+const int JIT_MAX_DEPTH = 50000; // native recursion limit before bailing out
+const int JIT_MAX_ARG_WORDS = 16;
+
+// x86-64 register numbers
+enum JitReg
+{
+	RAX = 0,
+	RCX = 1,
+	RDX = 2,
+	RBX = 3,
+	RSP = 4,
+	RBP = 5,
+	RSI = 6,
+	RDI = 7,
+};
+
+// condition codes for the two byte jcc rel32 form (0x0F, cc)
+const uint8_t JCC_E = 0x84;
+const uint8_t JCC_NE = 0x85;
+const uint8_t JCC_AE = 0x83;
+
+// condition codes for setcc (0x0F, cc)
+const uint8_t SET_E = 0x94;
+const uint8_t SET_NE = 0x95;
+const uint8_t SET_L = 0x9C;
+const uint8_t SET_GE = 0x9D;
+const uint8_t SET_LE = 0x9E;
+const uint8_t SET_G = 0x9F;
+
+class JitAssembler
+{
+public:
+	std::vector<uint8_t> code;
+
+	size_t pos() { return code.size(); }
+
+	void emit(std::initializer_list<uint8_t> bytes)
+	{
+		code.insert(code.end(), bytes.begin(), bytes.end());
+	}
+
+	void imm32(int32_t value)
+	{
+		uint8_t bytes[4];
+		memcpy(bytes, &value, 4);
+		code.insert(code.end(), bytes, bytes + 4);
+	}
+
+	void imm64(uint64_t value)
+	{
+		uint8_t bytes[8];
+		memcpy(bytes, &value, 8);
+		code.insert(code.end(), bytes, bytes + 8);
+	}
+
+	// emits a rel32 placeholder and returns its position for patch()
+	size_t rel32()
+	{
+		size_t at = pos();
+		imm32(0);
+		return at;
+	}
+
+	void patch(size_t at, size_t target)
+	{
+		int32_t rel = (int32_t)target - (int32_t)(at + 4);
+		memcpy(&code[at], &rel, 4);
+	}
+
+	void jmp(size_t target)
+	{
+		emit({0xE9});
+		patch(rel32(), target);
+	}
+
+	size_t jmpForward()
+	{
+		emit({0xE9});
+		return rel32();
+	}
+
+	void jcc(uint8_t cc, size_t target)
+	{
+		emit({0x0F, cc});
+		patch(rel32(), target);
+	}
+
+	size_t jccForward(uint8_t cc)
+	{
+		emit({0x0F, cc});
+		return rel32();
+	}
+
+	void call(size_t target)
+	{
+		emit({0xE8});
+		patch(rel32(), target);
+	}
+};
+
+struct JitVar
+{
+	JitType type;
+	int disp; // offset from the frame base, arrays use disp (data) and disp + 8 (length)
+};
+
+// Walks a function body emitting one fixed machine code template per node.
+// Expression results are left in eax, temporaries go on the native stack.
+class JitCodegen
+{
+public:
+	JitAssembler a;
+	bool failed = false;
+
+	int base = RBP;
+	int frameSize = 0;
+	std::unordered_map<std::string, JitVar> vars;
+	std::unordered_set<std::string> defined; // variables definitely assigned at this point
+
+	Environment *env = nullptr; // scope free names resolve in
+	std::string selfName;
+	bool usesSelf = false;
+	std::vector<JitInline> inlines;
+	std::vector<JitType> paramTypes;
+	int argWords = 0;
+	JitType returnType = JIT_NONE;
+
+	size_t bailLabel = 0;
+	size_t bodyLabel = 0;
+	size_t restartLabel = 0; // after the parameters are copied in, target of tail self calls
+	std::vector<int> paramDisps;
+	std::vector<size_t> returnFixups;
+
+	uint64_t integerVtable;
+	int integerValueOffset;
+
+	JitCodegen()
+	{
+		Integer probe(0);
+		memcpy(&integerVtable, &probe, sizeof(integerVtable));
+		integerValueOffset = (int)((char *)&probe.value - (char *)&probe);
+	}
+
+	JitType fail()
+	{
+		failed = true;
+		return JIT_NONE;
+	}
+
+	int newSlot()
+	{
+		frameSize += 8;
+		return -frameSize;
+	}
+
+	uint8_t modrm(int reg) { return 0x80 | (reg << 3) | base; }
+
+	void load(int disp) // mov eax, [base + disp]
+	{
+		a.emit({0x8B, modrm(RAX)});
+		a.imm32(disp);
+	}
+
+	void store(int disp) // mov [base + disp], eax
+	{
+		a.emit({0x89, modrm(RAX)});
+		a.imm32(disp);
+	}
+
+	void load64(int disp) // mov rax, [base + disp]
+	{
+		a.emit({0x48, 0x8B, modrm(RAX)});
+		a.imm32(disp);
+	}
+
+	void store64(int disp) // mov [base + disp], rax
+	{
+		a.emit({0x48, 0x89, modrm(RAX)});
+		a.imm32(disp);
+	}
+
+	void pushRax() { a.emit({0x50}); }
+	void popRax() { a.emit({0x58}); }
+
+	void setcc(uint8_t cc) // setcc al; movzx eax, al
+	{
+		a.emit({0x0F, cc, 0xC0});
+		a.emit({0x0F, 0xB6, 0xC0});
+	}
+
+	void bail() { a.jmp(bailLabel); }
+
+	void emitReturn(JitType type)
+	{
+		if (type != JIT_INT && type != JIT_BOOL)
+		{
+			fail();
+			return;
+		}
+
+		if (returnType == JIT_NONE)
+			returnType = type;
+		else if (returnType != type)
+		{
+			fail();
+			return;
+		}
+
+		returnFixups.push_back(a.jmpForward());
+	}
+
+	// evaluates a condition and leaves the flags of "test eax, eax"
+	void compileCondition(Expression *condition)
+	{
+		JitType type = compileExpression(condition);
+
+		if (type != JIT_INT && type != JIT_BOOL)
+		{
+			fail();
+			return;
+		}
+
+		a.emit({0x85, 0xC0});
+	}
+
+	JitVar *arrayVar(Expression *expr)
+	{
+		if (expr == nullptr || expr->nodeType() != "Identifier")
+			return nullptr;
+
+		std::string name = ((Identifier *)expr)->value;
+
+		if (vars.find(name) == vars.end() || !isJitArray(vars[name].type))
+			return nullptr;
+
+		return &vars[name];
+	}
+
+	JitType compileExpression(Expression *expr)
+	{
+		if (failed || expr == nullptr)
+			return fail();
+
+		std::string nodeType = expr->nodeType();
+
+		if (nodeType == "IntegerLiteral")
+		{
+			a.emit({0xB8}); // mov eax, imm32
+			a.imm32(((IntegerLiteral *)expr)->value);
+			return JIT_INT;
+		}
+
+		else if (nodeType == "BooleanLiteral")
+		{
+			a.emit({0xB8});
+			a.imm32(((BooleanLiteral *)expr)->value ? 1 : 0);
+			return JIT_BOOL;
+		}
+
+		else if (nodeType == "Identifier")
+		{
+			std::string name = ((Identifier *)expr)->value;
+
+			if (vars.find(name) == vars.end() || defined.find(name) == defined.end())
+				return fail();
+
+			JitVar var = vars[name];
+			if (isJitArray(var.type))
+				return fail();
+
+			load(var.disp);
+			return var.type;
+		}
+
+		else if (nodeType == "PrefixExpression")
+			return compilePrefix((PrefixExpression *)expr);
+
+		else if (nodeType == "InfixExpression")
+			return compileInfix((InfixExpression *)expr);
+
+		else if (nodeType == "IndexExpression")
+			return compileIndex((IndexExpression *)expr);
+
+		else if (nodeType == "CallExpression")
+			return compileCall((CallExpression *)expr);
+
+		else if (nodeType == "InlinedCall")
+			return compileInlined((InlinedCall *)expr);
+
+		return fail();
+	}
+
+	JitType compilePrefix(PrefixExpression *expr)
+	{
+		JitType type = compileExpression(expr->right);
+
+		if (expr->operand == "-" && type == JIT_INT)
+		{
+			a.emit({0xF7, 0xD8}); // neg eax
+			return JIT_INT;
+		}
+
+		else if (expr->operand == "!" && type == JIT_INT)
+		{
+			a.emit({0x85, 0xC0}); // test eax, eax
+			setcc(SET_E);
+			return JIT_BOOL;
+		}
+
+		else if (expr->operand == "!" && type == JIT_BOOL)
+		{
+			a.emit({0x83, 0xF0, 0x01}); // xor eax, 1
+			return JIT_BOOL;
+		}
+
+		return fail();
+	}
+
+	JitType compileInfix(InfixExpression *expr)
+	{
+		JitType left = compileExpression(expr->left);
+		pushRax();
+		JitType right = compileExpression(expr->right);
+		a.emit({0x89, 0xC1}); // mov ecx, eax
+		popRax();
+		if (failed)
+			return JIT_NONE;
+
+		std::string op = expr->operand;
+
+		if (left == JIT_INT && right == JIT_INT)
+		{
+			if (op == "+")
+				a.emit({0x01, 0xC8}); // add eax, ecx
+			else if (op == "-")
+				a.emit({0x29, 0xC8}); // sub eax, ecx
+			else if (op == "*")
+				a.emit({0x0F, 0xAF, 0xC1}); // imul eax, ecx
+			else if (op == "/" || op == "%")
+				compileDivision(op == "%");
+			else
+				return compileCompare(op);
+
+			return JIT_INT;
+		}
+
+		else if (left == JIT_BOOL && right == JIT_BOOL && (op == "==" || op == "!="))
+			return compileCompare(op);
+
+		return fail();
+	}
+
+	void compileDivision(bool modulo)
+	{
+		a.emit({0x85, 0xC9}); // test ecx, ecx
+		a.jcc(JCC_E, bailLabel);
+
+		// x / -1 and x % -1 are done without idiv, which traps on INT_MIN / -1
+		a.emit({0x83, 0xF9, 0xFF}); // cmp ecx, -1
+		size_t notMinusOne = a.jccForward(JCC_NE);
+		if (modulo)
+			a.emit({0x31, 0xC0}); // xor eax, eax
+		else
+			a.emit({0xF7, 0xD8}); // neg eax
+		size_t done = a.jmpForward();
+
+		a.patch(notMinusOne, a.pos());
+		a.emit({0x99});		  // cdq
+		a.emit({0xF7, 0xF9}); // idiv ecx
+		if (modulo)
+			a.emit({0x89, 0xD0}); // mov eax, edx
+
+		a.patch(done, a.pos());
+	}
+
+	JitType compileCompare(const std::string &op)
+	{
+		uint8_t cc;
+
+		if (op == "==")
+			cc = SET_E;
+		else if (op == "!=")
+			cc = SET_NE;
+		else if (op == "<")
+			cc = SET_L;
+		else if (op == ">")
+			cc = SET_G;
+		else if (op == "<=")
+			cc = SET_LE;
+		else if (op == ">=")
+			cc = SET_GE;
+		else
+			return fail();
+
+		a.emit({0x39, 0xC8}); // cmp eax, ecx
+		setcc(cc);
+
+		return JIT_BOOL;
+	}
+
+	JitType compileIndex(IndexExpression *expr)
+	{
+		JitVar *array = arrayVar(expr->array);
+
+		if (array == nullptr)
+			return fail();
+
+		int dataDisp = array->disp;
+		int lenDisp = array->disp + 8;
+
+		if (compileExpression(expr->index) != JIT_INT)
+			return fail();
+
+		a.emit({0x89, 0xC1}); // mov ecx, eax
+		a.emit({0x3B, modrm(RCX)}); // cmp ecx, [base + len]
+		a.imm32(lenDisp);
+		a.jcc(JCC_AE, bailLabel); // unsigned, so negative indexes bail too
+
+		load64(dataDisp);
+
+		if (array->type == JIT_INT_ARRAY)
+		{
+			a.emit({0x8B, 0x04, 0x88}); // mov eax, [rax + rcx * 4]
+			return JIT_INT;
+		}
+
+		a.emit({0x48, 0x8B, 0x04, 0xC8}); // mov rax, [rax + rcx * 8]
+
+		// type guard: the element must be an Integer
+		a.emit({0x48, 0x8B, 0x10}); // mov rdx, [rax]
+		a.emit({0x48, 0xB9});		// mov rcx, imm64
+		a.imm64(integerVtable);
+		a.emit({0x48, 0x39, 0xCA}); // cmp rdx, rcx
+		a.jcc(JCC_NE, bailLabel);
+
+		a.emit({0x8B, 0x80}); // mov eax, [rax + value]
+		a.imm32(integerValueOffset);
+
+		return JIT_INT;
+	}
+
+	// pushes the arguments of a recursive call in the same layout the entry
+	// trampoline receives them
+	bool pushSelfArguments(CallExpression *expr)
+	{
+		if (expr->arguments.size() != paramTypes.size())
+			return false;
+
+		for (size_t i = 0; i < paramTypes.size(); i++)
+		{
+			if (isJitArray(paramTypes[i]))
+			{
+				JitVar *array = arrayVar(expr->arguments[i]);
+
+				if (array == nullptr || array->type != paramTypes[i])
+					return false;
+
+				load64(array->disp);
+				pushRax();
+				load64(array->disp + 8);
+				pushRax();
+			}
+			else
+			{
+				if (compileExpression(expr->arguments[i]) != paramTypes[i])
+					return false;
+
+				pushRax();
+			}
+		}
+
+		return true;
+	}
+
+	// A recursive call whose result is returned as is overwrites the
+	// parameters and jumps back to the start of the body instead of calling,
+	// so tail recursion runs in one native frame
+	bool compileTailSelfCall(Expression *expr)
+	{
+		if (expr == nullptr || expr->nodeType() != "CallExpression" || base != RBP || selfName.empty())
+			return false;
+
+		CallExpression *call = (CallExpression *)expr;
+
+		if (call->function == nullptr || call->function->nodeType() != "Identifier" ||
+			((Identifier *)call->function)->value != selfName || vars.find(selfName) != vars.end())
+			return false;
+
+		if (!pushSelfArguments(call))
+		{
+			fail();
+			return true;
+		}
+
+		for (size_t i = paramTypes.size(); i-- > 0;)
+		{
+			if (isJitArray(paramTypes[i]))
+			{
+				popRax();
+				store64(paramDisps[i] + 8);
+			}
+
+			popRax();
+			store64(paramDisps[i]);
+		}
+
+		a.jmp(restartLabel);
+		usesSelf = true;
+
+		return true;
+	}
+
+	// whether a free name refers to the builtin: bound by the Resolver, or at
+	// least not shadowed by anything visible when compiling
+	bool isBuiltin(Identifier *ident)
+	{
+		return ident->builtin != nullptr || (env != nullptr && env->Lookup(ident->value) == nullptr);
+	}
+
+	// the inlined expression in place of the call, as long as the name refers
+	// to the inlined function now, checked again on every entry
+	JitType compileInlined(InlinedCall *inlined)
+	{
+		std::string name = ((Identifier *)inlined->call->function)->value;
+		Object *fn = env == nullptr ? nullptr : env->Lookup(name);
+
+		if (vars.find(name) != vars.end() || fn == nullptr || fn->type() != FUNCTION_OBJ || ((Function *)fn)->body != inlined->body)
+			return fail();
+
+		inlines.push_back({name, inlined->body});
+		return compileExpression(inlined->expression);
+	}
+
+	JitType compileCall(CallExpression *expr)
+	{
+		if (expr->function == nullptr || expr->function->nodeType() != "Identifier")
+			return fail();
+
+		std::string name = ((Identifier *)expr->function)->value;
+
+		if (vars.find(name) != vars.end())
+			return fail();
+
+		if (name == "len" && expr->arguments.size() == 1 && isBuiltin((Identifier *)expr->function))
+		{
+			JitVar *array = arrayVar(expr->arguments[0]);
+
+			if (array == nullptr)
+				return fail();
+
+			load(array->disp + 8);
+			return JIT_INT;
+		}
+
+		if (name != selfName || !pushSelfArguments(expr))
+			return fail();
+
+		a.emit({0x48, 0x89, 0xE7}); // mov rdi, rsp
+		a.call(bodyLabel);
+		a.emit({0x48, 0x81, 0xC4}); // add rsp, imm32
+		a.imm32(8 * argWords);
+
+		usesSelf = true;
+
+		// the return type is only known once a return is compiled, assume int until then
+		if (returnType == JIT_NONE)
+			returnType = JIT_INT;
+
+		return returnType;
+	}
+
+	void compileStatement(Statement *stmt)
+	{
+		if (failed || stmt == nullptr)
+		{
+			fail();
+			return;
+		}
+
+		std::string nodeType = stmt->nodeType();
+
+		if (nodeType == "LetStatement" || nodeType == "AssignStatement")
+		{
+			bool let = nodeType == "LetStatement";
+			std::string name = let ? ((LetStatement *)stmt)->name.value : ((AssignStatement *)stmt)->name.value;
+			Expression *value = let ? ((LetStatement *)stmt)->value : ((AssignStatement *)stmt)->value;
+
+			JitType type = compileExpression(value);
+
+			if (type != JIT_INT && type != JIT_BOOL)
+			{
+				fail();
+				return;
+			}
+
+			if (vars.find(name) == vars.end())
+			{
+				if (!let)
+				{
+					fail();
+					return;
+				}
+
+				vars[name] = {type, newSlot()};
+			}
+
+			if (vars[name].type != type || (!let && defined.find(name) == defined.end()))
+			{
+				fail();
+				return;
+			}
+
+			store(vars[name].disp);
+			defined.insert(name);
+		}
+
+		else if (nodeType == "ReturnStatement")
+		{
+			if (!compileTailSelfCall(((ReturnStatement *)stmt)->returnValue))
+				emitReturn(compileExpression(((ReturnStatement *)stmt)->returnValue));
+		}
+
+		else if (nodeType == "ExpressionStatement")
+		{
+			Expression *expr = ((ExpressionStatement *)stmt)->expression;
+
+			if (expr == nullptr)
+				fail();
+			else if (expr->nodeType() == "IfExpression")
+				compileIf((IfExpression *)expr, false);
+			else if (expr->nodeType() == "WhileExpression")
+				compileWhile((WhileExpression *)expr);
+			else if (compileExpression(expr) == JIT_NONE)
+				fail();
+		}
+
+		else
+			fail();
+	}
+
+	// the value of a statement in tail position is the function's result
+	void compileTail(Statement *stmt)
+	{
+		if (failed || stmt == nullptr)
+		{
+			fail();
+			return;
+		}
+
+		if (stmt->nodeType() == "ExpressionStatement")
+		{
+			Expression *expr = ((ExpressionStatement *)stmt)->expression;
+
+			if (expr != nullptr && expr->nodeType() == "IfExpression")
+				compileIf((IfExpression *)expr, true);
+
+			else if (expr != nullptr && expr->nodeType() == "WhileExpression")
+			{
+				compileWhile((WhileExpression *)expr);
+				bail(); // evaluates to null
+			}
+
+			else if (!compileTailSelfCall(expr))
+				emitReturn(compileExpression(expr));
+		}
+
+		else if (stmt->nodeType() == "ReturnStatement")
+			compileStatement(stmt);
+
+		else
+		{
+			compileStatement(stmt);
+			bail(); // let and assignment evaluate to null
+		}
+	}
+
+	void compileBlock(BlockStatement *block, bool tail)
+	{
+		std::unordered_set<std::string> saved = defined;
+
+		for (size_t i = 0; i < block->statements.size(); i++)
+		{
+			if (tail && i + 1 == block->statements.size())
+				compileTail(block->statements[i]);
+			else
+				compileStatement(block->statements[i]);
+		}
+
+		if (tail && block->statements.empty())
+			bail();
+
+		defined = saved;
+	}
+
+	void compileIf(IfExpression *expr, bool tail)
+	{
+		compileCondition(expr->condition);
+		size_t alternative = a.jccForward(JCC_E);
+
+		compileBlock(expr->consequence, tail);
+		size_t end = a.jmpForward();
+
+		a.patch(alternative, a.pos());
+		if (expr->alternative != nullptr)
+			compileBlock(expr->alternative, tail);
+		else if (tail)
+			bail();
+
+		a.patch(end, a.pos());
+	}
+
+	void compileWhile(WhileExpression *expr)
+	{
+		size_t top = a.pos();
+
+		compileCondition(expr->condition);
+		size_t end = a.jccForward(JCC_E);
+
+		compileBlock(expr->consequence, false);
+		a.jmp(top);
+
+		a.patch(end, a.pos());
+	}
+
+	void compileFunction(Function *fn)
+	{
+		// entry trampoline: int entry(int64_t *args, int64_t *result)
+		a.emit({0x53, 0x55, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57}); // push rbx, rbp, r12-r15
+		a.emit({0x49, 0x89, 0xF4});											 // mov r12, rsi
+		a.emit({0x49, 0x89, 0xE5});											 // mov r13, rsp
+		a.emit({0x41, 0xBE});												 // mov r14d, imm32
+		a.imm32(JIT_MAX_DEPTH);
+		a.emit({0xE8});
+		size_t callBody = a.rel32();
+		a.emit({0x49, 0x89, 0x04, 0x24}); // mov [r12], rax
+		a.emit({0x31, 0xC0});			  // xor eax, eax
+		size_t exitLabel = a.pos();
+		a.emit({0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5D, 0x5B, 0xC3}); // pop r15-r12, rbp, rbx; ret
+
+		// bailout: drop every native frame and report failure
+		bailLabel = a.pos();
+		a.emit({0x4C, 0x89, 0xEC}); // mov rsp, r13
+		a.emit({0xB8});				// mov eax, 1
+		a.imm32(1);
+		a.jmp(exitLabel);
+
+		// body: args pointer in rdi, params copied into the frame
+		bodyLabel = a.pos();
+		a.patch(callBody, bodyLabel);
+		a.emit({0x55});				// push rbp
+		a.emit({0x48, 0x89, 0xE5}); // mov rbp, rsp
+		a.emit({0x48, 0x81, 0xEC}); // sub rsp, imm32
+		size_t frameFixup = a.pos();
+		a.imm32(0);
+		a.emit({0x41, 0x83, 0xEE, 0x01}); // sub r14d, 1
+		a.jcc(JCC_E, bailLabel);
+
+		int word = 0;
+		for (size_t i = 0; i < fn->parameters.size(); i++)
+		{
+			int disp = newSlot();
+			if (isJitArray(paramTypes[i]))
+				disp = newSlot(); // data at disp, length at disp + 8
+
+			int words = isJitArray(paramTypes[i]) ? 2 : 1;
+			for (int w = 0; w < words; w++, word++)
+			{
+				a.emit({0x48, 0x8B, 0x87}); // mov rax, [rdi + disp32]
+				a.imm32(8 * (argWords - 1 - word));
+				store64(disp + 8 * w);
+			}
+
+			vars[fn->parameters[i]->value] = {paramTypes[i], disp};
+			defined.insert(fn->parameters[i]->value);
+			paramDisps.push_back(disp);
+		}
+
+		restartLabel = a.pos();
+
+		compileBlock(fn->body, true);
+
+		size_t returnLabel = a.pos();
+		a.emit({0x41, 0x83, 0xC6, 0x01}); // add r14d, 1
+		a.emit({0x48, 0x89, 0xEC});		  // mov rsp, rbp
+		a.emit({0x5D, 0xC3});			  // pop rbp; ret
+
+		for (auto fixup : returnFixups)
+			a.patch(fixup, returnLabel);
+
+		int32_t frame = frameSize;
+		memcpy(&a.code[frameFixup], &frame, 4);
+	}
+
+	// Compiles a running loop for on-stack replacement. Its variables live in a
+	// slot array owned by the caller (rbx): working values first, then a copy
+	// committed at every loop header, which is what a bailout resumes from.
+	void compileLoop(WhileExpression *loop, std::vector<std::string> &names, std::vector<JitType> &types, std::vector<bool> &written)
+	{
+		base = RBX;
+
+		int words = 0;
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			vars[names[i]] = {types[i], 8 * words};
+			defined.insert(names[i]);
+			words += isJitArray(types[i]) ? 2 : 1;
+		}
+
+		// entry trampoline: int entry(int64_t *slots, int64_t *unused)
+		a.emit({0x53, 0x55, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57}); // push rbx, rbp, r12-r15
+		a.emit({0x49, 0x89, 0xE5});											 // mov r13, rsp
+		a.emit({0x48, 0x89, 0xFB});											 // mov rbx, rdi
+		size_t start = a.jmpForward();
+
+		size_t exitLabel = a.pos();
+		a.emit({0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5D, 0x5B, 0xC3}); // pop r15-r12, rbp, rbx; ret
+
+		bailLabel = a.pos();
+		a.emit({0x4C, 0x89, 0xEC}); // mov rsp, r13
+		a.emit({0xB8});				// mov eax, 1
+		a.imm32(1);
+		a.jmp(exitLabel);
+
+		a.patch(start, a.pos());
+		size_t top = a.pos();
+
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			if (!written[i])
+				continue;
+
+			load64(vars[names[i]].disp);
+			store64(vars[names[i]].disp + 8 * words);
+		}
+
+		compileCondition(loop->condition);
+		size_t end = a.jccForward(JCC_E);
+
+		compileBlock(loop->consequence, false);
+		a.jmp(top);
+
+		a.patch(end, a.pos());
+		a.emit({0x31, 0xC0}); // xor eax, eax
+		a.jmp(exitLabel);
+
+		// a return inside the loop would have to leave the enclosing function
+		if (!returnFixups.empty())
+			fail();
+	}
+};
+
+// Collects the variables a loop reads and writes, call targets are not variables
+static void collectLoopNames(Node *node, std::vector<std::string> &names, std::vector<bool> &written)
+{
+	if (node == nullptr)
+		return;
+
+	std::string nodeType = node->nodeType();
+	std::string name;
+	bool write = false;
+
+	if (nodeType == "Identifier")
+		name = ((Identifier *)node)->value;
+
+	else if (nodeType == "LetStatement")
+	{
+		name = ((LetStatement *)node)->name.value;
+		write = true;
+		collectLoopNames(((LetStatement *)node)->value, names, written);
+	}
+
+	else if (nodeType == "AssignStatement")
+	{
+		name = ((AssignStatement *)node)->name.value;
+		write = true;
+		collectLoopNames(((AssignStatement *)node)->value, names, written);
+	}
+
+	else if (nodeType == "BlockStatement")
+		for (auto stmt : ((BlockStatement *)node)->statements)
+			collectLoopNames(stmt, names, written);
+
+	else if (nodeType == "ExpressionStatement")
+		collectLoopNames(((ExpressionStatement *)node)->expression, names, written);
+
+	else if (nodeType == "ReturnStatement")
+		collectLoopNames(((ReturnStatement *)node)->returnValue, names, written);
+
+	else if (nodeType == "PrefixExpression")
+		collectLoopNames(((PrefixExpression *)node)->right, names, written);
+
+	else if (nodeType == "InfixExpression")
+	{
+		collectLoopNames(((InfixExpression *)node)->left, names, written);
+		collectLoopNames(((InfixExpression *)node)->right, names, written);
+	}
+
+	else if (nodeType == "IndexExpression")
+	{
+		collectLoopNames(((IndexExpression *)node)->array, names, written);
+		collectLoopNames(((IndexExpression *)node)->index, names, written);
+	}
+
+	else if (nodeType == "CallExpression")
+		for (auto arg : ((CallExpression *)node)->arguments)
+			collectLoopNames(arg, names, written);
+
+	else if (nodeType == "InlinedCall")
+		collectLoopNames(((InlinedCall *)node)->expression, names, written);
+
+	else if (nodeType == "IfExpression")
+	{
+		collectLoopNames(((IfExpression *)node)->condition, names, written);
+		collectLoopNames(((IfExpression *)node)->consequence, names, written);
+		collectLoopNames(((IfExpression *)node)->alternative, names, written);
+	}
+
+	else if (nodeType == "WhileExpression")
+	{
+		collectLoopNames(((WhileExpression *)node)->condition, names, written);
+		collectLoopNames(((WhileExpression *)node)->consequence, names, written);
+	}
+
+	if (name.empty())
+		return;
+
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (names[i] == name)
+		{
+			written[i] = written[i] || write;
+			return;
+		}
+	}
+
+	names.push_back(name);
+	written.push_back(write);
+}
+
+static bool inlinesHold(std::vector<JitInline> &inlines, Environment *env)
+{
+	for (auto &inlined : inlines)
+	{
+		Object *fn = env->Lookup(inlined.name);
+
+		if (fn == nullptr || fn->type() != FUNCTION_OBJ || ((Function *)fn)->body != inlined.body)
+			return false;
+	}
+
+	return true;
+}
+
+static void *mapExecutable(std::vector<uint8_t> &code)
+{
+	void *mem = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (mem == MAP_FAILED)
+		return nullptr;
+
+	memcpy(mem, code.data(), code.size());
+
+	if (mprotect(mem, code.size(), PROT_READ | PROT_EXEC) != 0)
+	{
+		munmap(mem, code.size());
+		return nullptr;
+	}
+
+	return mem;
+}
+
+// the first of the two words an array is passed as
+static int64_t jitArrayData(Array *array)
+{
+	return array->isPacked() ? (int64_t)array->intData() : (int64_t)array->data();
+}
+
+static JitType jitTypeOf(Object *obj)
+{
+	if (obj == nullptr)
+		return JIT_NONE;
+
+	ObjectType type = obj->type();
+
+	if (type == INTEGER_OBJ)
+		return JIT_INT;
+	else if (type == BOOLEAN_OBJ)
+		return JIT_BOOL;
+	else if (type == ARRAY_OBJ)
+		return ((Array *)obj)->isPacked() ? JIT_INT_ARRAY : JIT_ARRAY;
+
+	return JIT_NONE;
+}
+
+JitFunction *Jit::Compile(Function *fn, std::string selfName, std::vector<Object *> &args)
+{
+	if (args.size() != fn->parameters.size())
+		return nullptr;
+
+	JitCodegen codegen;
+	codegen.env = fn->env;
+	codegen.selfName = selfName;
+
+	for (auto arg : args)
+	{
+		JitType type = jitTypeOf(arg);
+
+		if (type == JIT_NONE)
+			return nullptr;
+
+		codegen.paramTypes.push_back(type);
+		codegen.argWords += isJitArray(type) ? 2 : 1;
+	}
+
+	if (codegen.argWords > JIT_MAX_ARG_WORDS)
+		return nullptr;
+
+	codegen.compileFunction(fn);
+
+	if (codegen.failed || codegen.returnType == JIT_NONE)
+		return nullptr;
+
+	void *mem = mapExecutable(codegen.a.code);
+
+	if (mem == nullptr)
+		return nullptr;
+
+	JitFunction *jitted = new JitFunction();
+	jitted->entry = (JitEntryFn)mem;
+	jitted->code = mem;
+	jitted->size = codegen.a.code.size();
+	jitted->paramTypes = codegen.paramTypes;
+	jitted->argWords = codegen.argWords;
+	jitted->returnType = codegen.returnType;
+	jitted->selfName = selfName;
+	jitted->usesSelf = codegen.usesSelf;
+	jitted->inlines = codegen.inlines;
+
+	return jitted;
+}
+
+Object *Jit::Call(JitFunction *code, Function *fn, std::vector<Object *> &args)
+{
+	if (args.size() != code->paramTypes.size())
+		return nullptr;
+
+	int64_t words[JIT_MAX_ARG_WORDS];
+	int word = code->argWords - 1; // the native layout is reversed, as pushed on the stack
+
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		if (jitTypeOf(args[i]) != code->paramTypes[i])
+			return nullptr;
+
+		if (isJitArray(code->paramTypes[i]))
+		{
+			words[word--] = jitArrayData((Array *)args[i]);
+			words[word--] = (int64_t)((Array *)args[i])->size();
+		}
+		else if (code->paramTypes[i] == JIT_BOOL)
+			words[word--] = args[i] == __TRUE;
+		else
+			words[word--] = ((Integer *)args[i])->value;
+	}
+
+	// recursive calls were compiled as direct calls, valid while the name still refers to fn
+	if (code->usesSelf && fn->env->Lookup(code->selfName) != fn)
+		return nullptr;
+
+	if (!inlinesHold(code->inlines, fn->env))
+		return nullptr;
+
+	int64_t result;
+	if (code->entry(words, &result) != 0)
+		return nullptr;
+
+	if (code->returnType == JIT_BOOL)
+		return result & 1 ? __TRUE : __FALSE;
+
+	return new Integer((int)result);
+}
+
+JitLoop *Jit::CompileLoop(WhileExpression *loop, Environment *env)
+{
+	JitCodegen codegen;
+	codegen.env = env;
+	JitLoop *jitted = new JitLoop();
+
+	collectLoopNames(loop, jitted->names, jitted->written);
+
+	jitted->words = 0;
+	for (size_t i = 0; i < jitted->names.size(); i++)
+	{
+		JitType type = jitTypeOf(env->Lookup(jitted->names[i]));
+
+		// arrays are only read, their elements can't change while native code runs
+		if (type == JIT_NONE || (isJitArray(type) && jitted->written[i]))
+		{
+			delete jitted;
+			return nullptr;
+		}
+
+		jitted->types.push_back(type);
+		jitted->words += isJitArray(type) ? 2 : 1;
+	}
+
+	codegen.compileLoop(loop, jitted->names, jitted->types, jitted->written);
+
+	void *mem = codegen.failed ? nullptr : mapExecutable(codegen.a.code);
+
+	if (mem == nullptr)
+	{
+		delete jitted;
+		return nullptr;
+	}
+
+	jitted->entry = (JitEntryFn)mem;
+	jitted->code = mem;
+	jitted->size = codegen.a.code.size();
+	jitted->inlines = codegen.inlines;
+
+	return jitted;
+}
+
+JitLoopStatus Jit::RunLoop(JitLoop *loop, Environment *env)
+{
+	if (!inlinesHold(loop->inlines, env))
+		return JIT_LOOP_GUARD_FAILED;
+
+	std::vector<int64_t> slots(2 * loop->words);
+
+	int word = 0;
+	for (size_t i = 0; i < loop->names.size(); i++)
+	{
+		Object *obj = env->Lookup(loop->names[i]);
+
+		if (jitTypeOf(obj) != loop->types[i])
+			return JIT_LOOP_GUARD_FAILED;
+
+		if (isJitArray(loop->types[i]))
+		{
+			slots[word++] = jitArrayData((Array *)obj);
+			slots[word++] = (int64_t)((Array *)obj)->size();
+		}
+		else if (loop->types[i] == JIT_BOOL)
+			slots[word++] = obj == __TRUE;
+		else
+			slots[word++] = ((Integer *)obj)->value;
+	}
+
+	bool bailed = loop->entry(slots.data(), nullptr) != 0;
+
+	// write back what the loop assigned, as of the last loop header if it bailed out
+	int64_t *values = bailed ? slots.data() + loop->words : slots.data();
+
+	word = 0;
+	for (size_t i = 0; i < loop->names.size(); i++)
+	{
+		if (loop->written[i] && loop->types[i] == JIT_BOOL)
+			env->Set(loop->names[i], values[word] & 1 ? __TRUE : __FALSE);
+		else if (loop->written[i])
+			env->Set(loop->names[i], new Integer((int)values[word]));
+
+		word += isJitArray(loop->types[i]) ? 2 : 1;
+	}
+
+	return bailed ? JIT_LOOP_BAILED : JIT_LOOP_DONE;
+}
+
+#else
+
+JitLoop *Jit::CompileLoop(WhileExpression *loop, Environment *env)
+{
+	return nullptr;
+}
+
+JitLoopStatus Jit::RunLoop(JitLoop *loop, Environment *env)
+{
+	return JIT_LOOP_GUARD_FAILED;
+}
+
+JitFunction *Jit::Compile(Function *fn, std::string selfName, std::vector<Object *> &args)
+{
+	return nullptr;
+}
+
+Object *Jit::Call(JitFunction *code, Function *fn, std::vector<Object *> &args)
+{
+	return nullptr;
+}
+
+#endif
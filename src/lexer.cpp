@@ -79,17 +79,38 @@ Token Lexer::nextToken()
 		break;
 
 	case '+':
-		token = Token(PLUS, curChar);
+		if (peekChar() == '=')
+		{
+			token = Token(PLUS_ASSIGN, "+=");
+			readChar();
+		}
+		else
+			token = Token(PLUS, curChar);
+
 		readChar();
 		break;
 
 	case '-':
-		token = Token(MINUS, curChar);
+		if (peekChar() == '=')
+		{
+			token = Token(MINUS_ASSIGN, "-=");
+			readChar();
+		}
+		else
+			token = Token(MINUS, curChar);
+
 		readChar();
 		break;
 
 	case '*':
-		token = Token(ASTERISK, curChar);
+		if (peekChar() == '=')
+		{
+			token = Token(ASTERISK_ASSIGN, "*=");
+			readChar();
+		}
+		else
+			token = Token(ASTERISK, curChar);
+
 		readChar();
 		break;
 
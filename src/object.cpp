@@ -2,4 +2,259 @@
 
 Null *__NULL = new Null();
 Boolean *__TRUE = new Boolean(true);
-Boolean *__FALSE = new Boolean(false);
\ No newline at end of file
+Boolean *__FALSE = new Boolean(false);
+
+// Iterative, a string built by a loop of s = s + x is a chain as deep as the
+// loop ran. Nodes below this one are left as they are.
+void StringNode::flatten()
+{
+	if (flat())
+		return;
+
+	if (base != nullptr)
+	{
+		text.assign(base->text, offset, length);
+		base = nullptr;
+		offset = 0;
+
+		return;
+	}
+
+	std::string flat;
+	flat.reserve(length);
+
+	std::vector<StringNode *> pending = {this};
+
+	while (!pending.empty())
+	{
+		StringNode *part = pending.back();
+		pending.pop_back();
+
+		if (part->base != nullptr)
+			flat.append(part->base->text, part->offset, part->length);
+		else if (part->left == nullptr)
+			flat += part->text;
+		else
+		{
+			pending.push_back(part->right);
+			pending.push_back(part->left);
+		}
+	}
+
+	text.swap(flat);
+	left = right = nullptr;
+}
+
+String::String(String *left, String *right) : Object(), own("")
+{
+	if (left->length() + right->length() < STRING_SHARE_MIN)
+	{
+		own.text.reserve(left->length() + right->length());
+		own.text.append(left->node->data(), left->length());
+		own.text.append(right->node->data(), right->length());
+		own.length = own.text.size();
+		node = &own;
+
+		return;
+	}
+
+	node = new StringNode(left->node, right->node);
+	left->node->shared = true;
+	right->node->shared = true;
+}
+
+// views always refer to a flat node, a slice of a view to the view's base
+String::String(String *string, size_t start, size_t end) : Object(), own("")
+{
+	StringNode *source = string->node;
+
+	if (end - start < STRING_SHARE_MIN)
+	{
+		own.text.assign(source->data() + start, end - start);
+		own.length = own.text.size();
+		node = &own;
+
+		return;
+	}
+
+	if (source->base != nullptr)
+	{
+		start += source->offset;
+		source = source->base;
+	}
+	else
+		source->flatten();
+
+	source->shared = true;
+	node = new StringNode(source, start, end - start);
+}
+
+String::String(String *string) : Object(), own(""), node(string->node), hashValue(string->hashValue), hashed(string->hashed)
+{
+	node->shared = true;
+}
+
+Array::Array(std::vector<Object *> &elems) : Object()
+{
+	for (auto elem : elems)
+	{
+		if (!elem->isInteger())
+		{
+			packed = false;
+			items = std::make_shared<std::vector<Object *>>(elems);
+
+			return;
+		}
+	}
+
+	ints = std::make_shared<std::vector<int>>(elems.size());
+
+	for (size_t i = 0; i < elems.size(); i++)
+		(*ints)[i] = ((Integer *)elems[i])->value;
+
+	boxes = elems; // the Integers are there already
+}
+
+Array::Array(Array *array, size_t start, size_t end)
+	: Object(), ints(array->ints), items(array->items), packed(array->packed)
+{
+	view = true;
+	offset = array->offset + start;
+	count = end - start;
+}
+
+// own copy of the elements before changing them while a slice shares them
+void Array::unshare()
+{
+	if (packed && (view || ints.use_count() > 1))
+		ints = std::make_shared<std::vector<int>>(intData(), intData() + size());
+	else if (!packed && (view || items.use_count() > 1))
+		items = std::make_shared<std::vector<Object *>>(data(), data() + size());
+
+	view = false;
+	offset = 0;
+}
+
+Object *Array::boxed(size_t i)
+{
+	if (boxes.empty())
+		boxes.resize(size(), nullptr);
+
+	if (boxes[i] == nullptr)
+		boxes[i] = new Integer(intData()[i]);
+
+	return boxes[i];
+}
+
+void Array::unpack()
+{
+	std::vector<Object *> *boxed = new std::vector<Object *>(size());
+
+	for (size_t i = 0; i < size(); i++)
+		(*boxed)[i] = !boxes.empty() && boxes[i] != nullptr ? boxes[i] : new Integer(intData()[i]);
+
+	items.reset(boxed);
+	ints.reset();
+	std::vector<Object *>().swap(boxes);
+	packed = false;
+	view = false;
+	offset = 0;
+}
+
+void Array::set(size_t i, Object *value)
+{
+	if (packed && !value->isInteger())
+		unpack();
+
+	unshare();
+
+	if (packed)
+	{
+		(*ints)[i] = ((Integer *)value)->value;
+
+		if (!boxes.empty())
+			boxes[i] = value;
+	}
+	else
+		(*items)[i] = value;
+}
+
+void Array::push(Object *value)
+{
+	if (packed && !value->isInteger())
+		unpack();
+
+	unshare();
+
+	if (packed)
+	{
+		ints->push_back(((Integer *)value)->value);
+
+		if (!boxes.empty())
+			boxes.push_back(value);
+	}
+	else
+		items->push_back(value);
+}
+
+void Array::pop()
+{
+	unshare();
+
+	if (packed)
+	{
+		ints->pop_back();
+
+		if (!boxes.empty())
+			boxes.pop_back();
+	}
+	else
+		items->pop_back();
+}
+
+std::string &String::mutableText()
+{
+	node->flatten();
+
+	if (node->shared)
+		node = new StringNode(node->text);
+
+	hashed = false;
+	return node->text;
+}
+
+void String::append(const std::string &s)
+{
+	mutableText() += s;
+	node->length = node->text.size();
+}
+
+bool String::popBack()
+{
+	if (node->length == 0)
+		return false;
+
+	mutableText().pop_back();
+	node->length--;
+
+	return true;
+}
+
+std::string Error::inspect()
+{
+	switch (code)
+	{
+	case ERROR_IDENTIFIER_NOT_FOUND:
+		return "error : identifier not found -> " + detail;
+	case ERROR_NOT_A_FUNCTION:
+		return "error: not a function -> " + detail;
+	case ERROR_ARGUMENT_LENGTH:
+		return "error: argument length (" + std::to_string(got) + ") not equal to parameter length (" + std::to_string(want) + ")";
+	case ERROR_INDEX_OUT_OF_RANGE:
+		return "error: index " + std::to_string(got) + " out of range";
+	case ERROR_SLICE_OUT_OF_RANGE:
+		return "error: slice " + std::to_string(got) + ":" + std::to_string(want) + " out of range";
+	default:
+		return detail;
+	}
+}
@@ -0,0 +1,455 @@
+#include "../header/optimizer.hpp"
+
+void Optimizer::Optimize(Program *program)
+{
+	inlinable.clear();
+	scopes.clear();
+
+	collectInlinable(program);
+	optimize(program);
+}
+
+// number of nodes in expr if it is only literals, identifiers (parameters if
+// params is given) and operators, -1 otherwise
+static int pureSize(Expression *expr, std::unordered_set<std::string> *params)
+{
+	std::string nodeType = expr->nodeType();
+
+	if (nodeType == "IntegerLiteral" || nodeType == "BooleanLiteral" || nodeType == "StringLiteral")
+		return 1;
+
+	if (nodeType == "Identifier")
+		return params == nullptr || params->count(((Identifier *)expr)->value) ? 1 : -1;
+
+	if (nodeType == "PrefixExpression")
+	{
+		int right = pureSize(((PrefixExpression *)expr)->right, params);
+		return right < 0 ? -1 : right + 1;
+	}
+
+	if (nodeType == "InfixExpression")
+	{
+		int left = pureSize(((InfixExpression *)expr)->left, params);
+		int right = pureSize(((InfixExpression *)expr)->right, params);
+		return left < 0 || right < 0 ? -1 : left + right + 1;
+	}
+
+	return -1;
+}
+
+// the expression a function body consists of, nullptr if it has more to it
+static Expression *bodyExpression(FunctionLiteral *fn)
+{
+	if (fn->body->statements.size() != 1)
+		return nullptr;
+
+	Statement *stmt = fn->body->statements[0];
+
+	if (stmt->nodeType() == "ExpressionStatement")
+		return ((ExpressionStatement *)stmt)->expression;
+
+	if (stmt->nodeType() == "ReturnStatement")
+		return ((ReturnStatement *)stmt)->returnValue;
+
+	return nullptr;
+}
+
+static void countUses(Expression *expr, std::unordered_map<std::string, int> &uses)
+{
+	std::string nodeType = expr->nodeType();
+
+	if (nodeType == "Identifier")
+		uses[((Identifier *)expr)->value]++;
+	else if (nodeType == "PrefixExpression")
+		countUses(((PrefixExpression *)expr)->right, uses);
+	else if (nodeType == "InfixExpression")
+	{
+		countUses(((InfixExpression *)expr)->left, uses);
+		countUses(((InfixExpression *)expr)->right, uses);
+	}
+}
+
+// copy of a pure expression with parameters replaced by copies of their arguments
+static Expression *substitute(Expression *expr, std::unordered_map<std::string, Expression *> &args)
+{
+	std::string nodeType = expr->nodeType();
+
+	if (nodeType == "Identifier")
+	{
+		auto it = args.find(((Identifier *)expr)->value);
+
+		if (it != args.end())
+		{
+			std::unordered_map<std::string, Expression *> none;
+			return substitute(it->second, none);
+		}
+
+		return new Identifier(*(Identifier *)expr);
+	}
+
+	if (nodeType == "IntegerLiteral")
+	{
+		IntegerLiteral *literal = new IntegerLiteral(*(IntegerLiteral *)expr);
+		literal->constant = nullptr;
+		return literal;
+	}
+
+	if (nodeType == "BooleanLiteral")
+		return new BooleanLiteral(*(BooleanLiteral *)expr);
+
+	if (nodeType == "StringLiteral")
+		return new StringLiteral(*(StringLiteral *)expr);
+
+	if (nodeType == "PrefixExpression")
+	{
+		PrefixExpression *prefix = new PrefixExpression(*(PrefixExpression *)expr);
+		prefix->right = substitute(prefix->right, args);
+		return prefix;
+	}
+
+	InfixExpression *infix = new InfixExpression(*(InfixExpression *)expr);
+	infix->left = substitute(infix->left, args);
+	infix->right = substitute(infix->right, args);
+	return infix;
+}
+
+// counts the lets of each name in the global scope and collects every assigned name
+static void countBindings(Node *node, bool global, std::unordered_map<std::string, int> &lets, std::unordered_set<std::string> &assigned)
+{
+	std::string nodeType = node->nodeType();
+
+	if (nodeType == "LetStatement" && global)
+		lets[((LetStatement *)node)->name.value]++;
+
+	else if (nodeType == "AssignStatement")
+		assigned.insert(((AssignStatement *)node)->name.value);
+
+	for (auto child : childNodes(node))
+		countBindings(child, global && nodeType != "FunctionLiteral", lets, assigned);
+}
+
+void Optimizer::collectInlinable(Program *program)
+{
+	std::unordered_map<std::string, int> lets;
+	std::unordered_set<std::string> assigned;
+
+	countBindings(program, true, lets, assigned);
+
+	for (auto stmt : program->statements)
+	{
+		if (stmt->nodeType() != "LetStatement" || ((LetStatement *)stmt)->value->nodeType() != "FunctionLiteral")
+			continue;
+
+		std::string &name = ((LetStatement *)stmt)->name.value;
+		FunctionLiteral *fn = (FunctionLiteral *)((LetStatement *)stmt)->value;
+
+		if (lets[name] != 1 || assigned.count(name))
+			continue;
+
+		Expression *body = bodyExpression(fn);
+
+		if (body == nullptr)
+			continue;
+
+		std::unordered_set<std::string> params;
+
+		for (auto param : fn->parameters)
+			params.insert(param->value);
+
+		int size = pureSize(body, &params);
+
+		if (size > 0 && size <= INLINE_MAX_NODES && params.size() == fn->parameters.size())
+			inlinable[name] = fn;
+	}
+}
+
+// InlinedCall standing for call, or call itself if it can't be inlined
+Expression *Optimizer::inlineCall(CallExpression *call)
+{
+	if (call->function->nodeType() != "Identifier")
+		return call;
+
+	std::string &name = ((Identifier *)call->function)->value;
+	auto it = inlinable.find(name);
+
+	if (it == inlinable.end())
+		return call;
+
+	for (auto &scope : scopes)
+		if (scope.count(name))
+			return call;
+
+	FunctionLiteral *fn = it->second;
+
+	if (fn->parameters.size() != call->arguments.size())
+		return call;
+
+	Expression *body = bodyExpression(fn);
+	std::unordered_map<std::string, int> uses;
+	countUses(body, uses);
+
+	// arguments are evaluated as often as their parameter is used, which only
+	// makes no difference for side effect free ones that get used at all, and
+	// only costs nothing for names and literals
+	std::unordered_map<std::string, Expression *> args;
+
+	for (size_t i = 0; i < call->arguments.size(); i++)
+	{
+		Expression *arg = call->arguments[i];
+		int used = uses[fn->parameters[i]->value];
+
+		if (used == 0 || pureSize(arg, nullptr) < 0)
+			return call;
+
+		if (used > 1 && pureSize(arg, nullptr) > 1)
+			return call;
+
+		args[fn->parameters[i]->value] = arg;
+	}
+
+	InlinedCall *inlined = new InlinedCall();
+	inlined->call = call;
+	inlined->body = fn->body;
+	inlined->expression = fold(substitute(body, args));
+
+	return inlined;
+}
+
+// folds the expressions below node in place
+void Optimizer::optimize(Node *node)
+{
+	if (node == nullptr)
+		return;
+
+	std::string nodeType = node->nodeType();
+
+	if (nodeType == "Program")
+	{
+		for (auto stmt : ((Program *)node)->statements)
+			optimize(stmt);
+	}
+
+	else if (nodeType == "BlockStatement")
+	{
+		for (auto stmt : ((BlockStatement *)node)->statements)
+			optimize(stmt);
+	}
+
+	else if (nodeType == "ExpressionStatement")
+		((ExpressionStatement *)node)->expression = fold(((ExpressionStatement *)node)->expression);
+
+	else if (nodeType == "LetStatement")
+		((LetStatement *)node)->value = fold(((LetStatement *)node)->value);
+
+	else if (nodeType == "AssignStatement")
+		((AssignStatement *)node)->value = fold(((AssignStatement *)node)->value);
+
+	else if (nodeType == "IndexAssignStatement")
+	{
+		IndexAssignStatement *stmt = (IndexAssignStatement *)node;
+		stmt->target->array = fold(stmt->target->array);
+		stmt->target->index = fold(stmt->target->index);
+		stmt->value = fold(stmt->value);
+	}
+
+	else if (nodeType == "ReturnStatement")
+		((ReturnStatement *)node)->returnValue = fold(((ReturnStatement *)node)->returnValue);
+
+	else if (nodeType == "IntegerLiteral")
+		((IntegerLiteral *)node)->constant = new Integer(((IntegerLiteral *)node)->value);
+
+	else if (nodeType == "PrefixExpression")
+		((PrefixExpression *)node)->right = fold(((PrefixExpression *)node)->right);
+
+	else if (nodeType == "InfixExpression")
+	{
+		((InfixExpression *)node)->left = fold(((InfixExpression *)node)->left);
+		((InfixExpression *)node)->right = fold(((InfixExpression *)node)->right);
+	}
+
+	else if (nodeType == "IfExpression")
+	{
+		((IfExpression *)node)->condition = fold(((IfExpression *)node)->condition);
+		optimize(((IfExpression *)node)->consequence);
+		optimize(((IfExpression *)node)->alternative);
+	}
+
+	else if (nodeType == "WhileExpression")
+	{
+		((WhileExpression *)node)->condition = fold(((WhileExpression *)node)->condition);
+		optimize(((WhileExpression *)node)->consequence);
+	}
+
+	else if (nodeType == "FunctionLiteral")
+	{
+		std::unordered_set<std::string> declared;
+
+		for (auto param : ((FunctionLiteral *)node)->parameters)
+			declared.insert(param->value);
+
+		declaredNames(((FunctionLiteral *)node)->body, declared);
+
+		scopes.push_back(declared);
+		optimize(((FunctionLiteral *)node)->body);
+		scopes.pop_back();
+	}
+
+	else if (nodeType == "CallExpression")
+	{
+		((CallExpression *)node)->function = fold(((CallExpression *)node)->function);
+		optimizeAll(((CallExpression *)node)->arguments);
+	}
+
+	else if (nodeType == "IndexExpression")
+	{
+		((IndexExpression *)node)->array = fold(((IndexExpression *)node)->array);
+		((IndexExpression *)node)->index = fold(((IndexExpression *)node)->index);
+	}
+
+	else if (nodeType == "SliceExpression")
+	{
+		SliceExpression *slice = (SliceExpression *)node;
+		slice->array = fold(slice->array);
+		slice->start = fold(slice->start);
+
+		if (slice->end != nullptr)
+			slice->end = fold(slice->end);
+	}
+
+	else if (nodeType == "HashMapLiteral")
+	{
+		for (auto &pair : ((HashMapLiteral *)node)->pairs)
+		{
+			pair.key = fold(pair.key);
+			pair.value = fold(pair.value);
+		}
+	}
+
+	else if (nodeType == "ArrayLiteral")
+		optimizeAll(((ArrayLiteral *)node)->elements);
+	else if (nodeType == "HashSetLiteral")
+		optimizeAll(((HashSetLiteral *)node)->pairs);
+	else if (nodeType == "StackLiteral")
+		optimizeAll(((StackLiteral *)node)->elements);
+	else if (nodeType == "QueueLiteral")
+		optimizeAll(((QueueLiteral *)node)->elements);
+	else if (nodeType == "DequeLiteral")
+		optimizeAll(((DequeLiteral *)node)->elements);
+	else if (nodeType == "MaxHeapLiteral")
+		optimizeAll(((MaxHeapLiteral *)node)->elements);
+	else if (nodeType == "MinHeapLiteral")
+		optimizeAll(((MinHeapLiteral *)node)->elements);
+}
+
+void Optimizer::optimizeAll(std::vector<Expression *> &exprs)
+{
+	for (auto &expr : exprs)
+		expr = fold(expr);
+}
+
+// optimizes expr and returns what replaces it, a literal if it is constant
+Expression *Optimizer::fold(Expression *expr)
+{
+	if (expr == nullptr)
+		return expr;
+
+	optimize(expr);
+
+	std::string nodeType = expr->nodeType();
+
+	if (nodeType == "CallExpression")
+		return inlineCall((CallExpression *)expr);
+
+	if (nodeType == "PrefixExpression")
+	{
+		PrefixExpression *prefix = (PrefixExpression *)expr;
+		Object *right = literalValue(prefix->right);
+
+		if (right == nullptr)
+			return expr;
+
+		Expression *literal = toLiteral(evaluator.evalPrefixExpression(prefix->operand, right));
+
+		if (literal == nullptr)
+			return expr;
+
+		delete prefix->right;
+		delete prefix;
+
+		return literal;
+	}
+
+	if (nodeType == "InfixExpression")
+	{
+		InfixExpression *infix = (InfixExpression *)expr;
+		Object *left = literalValue(infix->left);
+		Object *right = literalValue(infix->right);
+
+		if (left == nullptr || right == nullptr)
+			return expr;
+
+		Expression *literal = toLiteral(evaluator.evalInfixExpression(infix->operand, left, right));
+
+		if (literal == nullptr)
+			return expr;
+
+		delete infix->left;
+		delete infix->right;
+		delete infix;
+
+		return literal;
+	}
+
+	return expr;
+}
+
+// value of a literal operand, nullptr if expr is not a literal
+Object *Optimizer::literalValue(Expression *expr)
+{
+	std::string nodeType = expr->nodeType();
+
+	if (nodeType == "IntegerLiteral")
+		return ((IntegerLiteral *)expr)->constant;
+
+	else if (nodeType == "BooleanLiteral")
+		return ((BooleanLiteral *)expr)->value ? __TRUE : __FALSE;
+
+	else if (nodeType == "StringLiteral")
+		return new String(((StringLiteral *)expr)->value);
+
+	return nullptr;
+}
+
+// literal node evaluating to value, nullptr for errors and other objects
+Expression *Optimizer::toLiteral(Object *value)
+{
+	if (value->type() == INTEGER_OBJ)
+	{
+		IntegerLiteral *literal = new IntegerLiteral();
+		literal->value = ((Integer *)value)->value;
+		literal->token = Token(INTEGER, std::to_string(literal->value));
+		literal->constant = value;
+
+		return literal;
+	}
+
+	else if (value == __TRUE || value == __FALSE)
+	{
+		BooleanLiteral *literal = new BooleanLiteral();
+		literal->value = value == __TRUE;
+		literal->token = literal->value ? Token(TRUE, "true") : Token(FALSE, "false");
+
+		return literal;
+	}
+
+	else if (value->type() == STRING_OBJ)
+	{
+		StringLiteral *literal = new StringLiteral();
+		literal->value = ((String *)value)->value();
+		literal->token = Token(STRING, literal->value);
+
+		return literal;
+	}
+
+	return nullptr;
+}
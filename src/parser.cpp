@@ -161,6 +161,9 @@ LetStatement *Parser::parseLetStatement()
 
 AssignStatement *Parser::parseAssignStatement()
 {
+	if (peekToken.type == PLUS_ASSIGN || peekToken.type == MINUS_ASSIGN || peekToken.type == ASTERISK_ASSIGN)
+		return parseCompoundAssignStatement();
+
 	AssignStatement *stmt = new AssignStatement();
 
 	if (peekToken.type != ASSIGN)
@@ -184,6 +187,64 @@ AssignStatement *Parser::parseAssignStatement()
 	return stmt;
 }
 
+// `x op= v;` becomes `x = x op v;` with op kept on the statement, so every
+// tier that handles assignment handles it too
+AssignStatement *Parser::parseCompoundAssignStatement()
+{
+	AssignStatement *stmt = new AssignStatement();
+
+	stmt->token = Token(ASSIGN, "ASSIGN");
+
+	stmt->name.token = curToken;
+	stmt->name.value = curToken.literal;
+
+	nextToken();
+
+	InfixExpression *expr = new InfixExpression();
+
+	if (curToken.type == PLUS_ASSIGN)
+		expr->token = Token(PLUS, "+");
+	else if (curToken.type == MINUS_ASSIGN)
+		expr->token = Token(MINUS, "-");
+	else
+		expr->token = Token(ASTERISK, "*");
+
+	expr->operand = expr->token.literal;
+	stmt->op = expr->operand;
+
+	expr->left = new Identifier(stmt->name.token, stmt->name.value);
+
+	nextToken();
+
+	expr->right = parseExpression(LOWEST);
+	stmt->value = expr;
+
+	if (peekToken.type == SEMICOLON)
+		nextToken();
+
+	return stmt;
+}
+
+IndexAssignStatement *Parser::parseIndexAssignStatement(IndexExpression *target)
+{
+	IndexAssignStatement *stmt = new IndexAssignStatement();
+
+	stmt->token = Token(ASSIGN, "ASSIGN");
+	stmt->target = target;
+
+	if (!expectPeek(ASSIGN))
+		return nullptr;
+
+	nextToken();
+
+	stmt->value = parseExpression(LOWEST);
+
+	if (peekToken.type == SEMICOLON)
+		nextToken();
+
+	return stmt;
+}
+
 bool Parser::expectPeek(const TokenType &tokenType)
 {
 	if (peekToken.type == tokenType)
@@ -249,12 +310,39 @@ ReturnStatement *Parser::parseReturnStatement()
 	return stmt;
 }
 
-ExpressionStatement *Parser::parseExpressionStatement()
+Statement *Parser::parseExpressionStatement()
 {
 	ExpressionStatement *stmt = new ExpressionStatement();
 	stmt->token = curToken;
 	stmt->expression = parseExpression(LOWEST);
 
+	// an indexed expression followed by = is the target of an assignment
+	if (peekToken.type == ASSIGN && stmt->expression != nullptr && stmt->expression->nodeType() == "IndexExpression")
+	{
+		IndexExpression *target = (IndexExpression *)stmt->expression;
+		delete stmt;
+
+		return parseIndexAssignStatement(target);
+	}
+
+	// `a[i] op= v` would have to evaluate a and i twice or need a statement of its own
+	if ((peekToken.type == PLUS_ASSIGN || peekToken.type == MINUS_ASSIGN || peekToken.type == ASTERISK_ASSIGN) &&
+		stmt->expression != nullptr && stmt->expression->nodeType() == "IndexExpression")
+	{
+		errors.push_back("error: " + peekToken.literal + " cannot assign to an indexed expression, write it out with =");
+		delete stmt;
+
+		// skip the rest of the statement
+		nextToken();
+		nextToken();
+		parseExpression(LOWEST);
+
+		if (peekToken.type == SEMICOLON)
+			nextToken();
+
+		return nullptr;
+	}
+
 	if (peekToken.type == SEMICOLON)
 		nextToken();
 
@@ -589,13 +677,56 @@ Expression *Parser::parseArrayLiteral()
 
 Expression *Parser::parseIndexExpression(Expression *array)
 {
+	Token token = curToken;
+
+	nextToken();
+
+	// `x[:end]`
+	if (curToken.type == COLON)
+	{
+		IntegerLiteral *start = new IntegerLiteral();
+		start->token = Token(INTEGER, "0");
+		start->value = 0;
+
+		return parseSliceExpression(token, array, start);
+	}
+
+	Expression *index = parseExpression(LOWEST);
+
+	if (peekToken.type == COLON)
+	{
+		nextToken();
+		return parseSliceExpression(token, array, index);
+	}
+
 	IndexExpression *exp = new IndexExpression();
-	exp->token = curToken;
+	exp->token = token;
 	exp->array = array;
+	exp->index = index;
 
-	nextToken();
+	if (!expectPeek(RBRACKET))
+	{
+		delete exp;
+		return nullptr;
+	}
+
+	return exp;
+}
+
+// the current token is the colon after start
+Expression *Parser::parseSliceExpression(Token token, Expression *array, Expression *start)
+{
+	SliceExpression *exp = new SliceExpression();
+	exp->token = token;
+	exp->array = array;
+	exp->start = start;
+	exp->end = nullptr;
 
-	exp->index = parseExpression(LOWEST);
+	if (peekToken.type != RBRACKET)
+	{
+		nextToken();
+		exp->end = parseExpression(LOWEST);
+	}
 
 	if (!expectPeek(RBRACKET))
 	{
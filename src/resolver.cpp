@@ -0,0 +1,99 @@
+#include "../header/resolver.hpp"
+#include "../header/builtins.hpp"
+
+void Resolver::Resolve(Program *program, Environment *env)
+{
+	std::unordered_set<std::string> globals;
+
+	for (Environment *scope = env; scope != nullptr; scope = scope->outer)
+		for (auto &name : scope->store.keys())
+			globals.insert(name);
+
+	declaredNames(program, globals);
+
+	for (auto it = bound.begin(); it != bound.end();)
+	{
+		if (globals.count(it->first) == 0)
+		{
+			++it;
+			continue;
+		}
+
+		for (auto ident : it->second)
+			ident->builtin = nullptr;
+
+		it = bound.erase(it);
+	}
+
+	scopes.clear();
+	scopes.push_back(globals);
+
+	resolve(program);
+}
+
+void Resolver::resolve(Node *node)
+{
+	std::string nodeType = node->nodeType();
+
+	if (nodeType == "Identifier")
+	{
+		Identifier *ident = (Identifier *)node;
+		auto it = builtin.find(ident->value);
+
+		if (it != builtin.end() && !shadowed(ident->value))
+		{
+			ident->builtin = it->second;
+			bound[ident->value].push_back(ident);
+		}
+
+		return;
+	}
+
+	if (nodeType == "FunctionLiteral")
+	{
+		FunctionLiteral *fn = (FunctionLiteral *)node;
+		std::unordered_set<std::string> locals;
+
+		for (auto param : fn->parameters)
+			locals.insert(param->value);
+
+		declaredNames(fn->body, locals);
+
+		scopes.push_back(locals);
+		resolve(fn->body);
+		scopes.pop_back();
+
+		return;
+	}
+
+	for (auto child : childNodes(node))
+		resolve(child);
+
+	// a call to a bound builtin always reaches the same Builtin, so its arity
+	// is checked here and the call site's inline cache starts out with it
+	if (nodeType == "CallExpression")
+	{
+		CallExpression *call = (CallExpression *)node;
+
+		if (call->function->nodeType() != "Identifier" || call->cached != 0)
+			return;
+
+		Builtin *fn = ((Identifier *)call->function)->builtin;
+
+		if (fn != nullptr && (fn->arity == BUILTIN_VARIADIC || (size_t)fn->arity == call->arguments.size()))
+		{
+			call->cache[0].callee = fn;
+			call->cache[0].builtin = true;
+			call->cached = 1;
+		}
+	}
+}
+
+bool Resolver::shadowed(std::string &name)
+{
+	for (auto &scope : scopes)
+		if (scope.find(name) != scope.end())
+			return true;
+
+	return false;
+}
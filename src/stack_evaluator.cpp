@@ -0,0 +1,561 @@
+#include "../header/stack_evaluator.hpp"
+
+Object *StackEvaluator::Eval(Node *node, Environment *env)
+{
+	frames.clear();
+	depth = 0;
+	overflow = nullptr;
+	returning = false;
+	tailCall.function = nullptr;
+
+	push(node, env);
+
+	// value of the frame that finished last, nullptr when the top frame was just pushed
+	Object *value = nullptr;
+
+	while (true)
+	{
+		Object *result = step(frames.size() - 1, value);
+
+		if (overflow != nullptr)
+		{
+			frames.clear();
+			depth = 0;
+			return overflow;
+		}
+
+		// a child frame was pushed
+		if (result == nullptr)
+		{
+			value = nullptr;
+			continue;
+		}
+
+		frames.pop_back();
+
+		if (frames.empty())
+			return result;
+
+		value = result;
+	}
+}
+
+void StackEvaluator::push(Node *node, Environment *env)
+{
+	std::string nodeType = node->nodeType();
+	StackFrameKind kind = FRAME_OPERANDS;
+
+	// an inlined call is whichever of its two forms applies, decided right away
+	if (nodeType == "InlinedCall")
+	{
+		InlinedCall *inlined = (InlinedCall *)node;
+		Expression *chosen = evaluator.inlineHolds(inlined, env) ? inlined->expression : (Expression *)inlined->call;
+
+		push(chosen, env);
+		return;
+	}
+
+	if (nodeType == "Program")
+		kind = FRAME_PROGRAM;
+	else if (nodeType == "BlockStatement")
+		kind = FRAME_BLOCK;
+	else if (nodeType == "IfExpression")
+		kind = FRAME_IF;
+	else if (nodeType == "WhileExpression")
+		kind = FRAME_WHILE;
+	else if (nodeType == "CallExpression")
+		kind = FRAME_CALL;
+	else if (nodeType == "ReturnStatement" && depth > 0 &&
+			 ((ReturnStatement *)node)->returnValue->nodeType() == "CallExpression")
+	{
+		node = ((ReturnStatement *)node)->returnValue;
+		kind = FRAME_TAIL_CALL;
+	}
+	else if (nodeType == "IntegerLiteral" || nodeType == "BooleanLiteral" || nodeType == "StringLiteral" ||
+			 nodeType == "Identifier" || nodeType == "FunctionLiteral")
+		kind = FRAME_VALUE;
+
+	frames.push_back(StackFrame(node, env, kind));
+}
+
+// Advances frame by one step. value is what its last pushed child evaluated
+// to, nullptr on the first step. Returns the frame's own value once it is
+// done, nullptr after pushing another child. Frames may move while a child is
+// pushed, so they are addressed by index.
+Object *StackEvaluator::step(size_t frame, Object *value)
+{
+	switch (frames[frame].kind)
+	{
+	case FRAME_PROGRAM:
+		return stepProgram(frame, value);
+	case FRAME_BLOCK:
+		return stepBlock(frame, value);
+	case FRAME_IF:
+		return stepIf(frame, value);
+	case FRAME_WHILE:
+		return stepWhile(frame, value);
+	case FRAME_CALL:
+	case FRAME_TAIL_CALL:
+		return stepCall(frame, value);
+	case FRAME_VALUE:
+		return evalValue(frames[frame].node, frames[frame].env);
+	default:
+		return stepOperands(frame, value);
+	}
+}
+
+Object *StackEvaluator::stepProgram(size_t frame, Object *value)
+{
+	StackFrame &f = frames[frame];
+	Program *program = (Program *)f.node;
+
+	if (value != nullptr)
+	{
+		if (returning)
+		{
+			returning = false;
+			return value;
+		}
+
+		else if (value->isError())
+			return value;
+
+		f.last = value;
+	}
+
+	if ((size_t)f.stage < program->statements.size())
+	{
+		push(program->statements[f.stage++], f.env);
+		return nullptr;
+	}
+
+	return f.last != nullptr ? f.last : __NULL;
+}
+
+Object *StackEvaluator::stepBlock(size_t frame, Object *value)
+{
+	StackFrame &f = frames[frame];
+	BlockStatement *block = (BlockStatement *)f.node;
+
+	if (value != nullptr)
+	{
+		if (returning || value->isError())
+			return value;
+
+		f.last = value;
+	}
+
+	if ((size_t)f.stage < block->statements.size())
+	{
+		push(block->statements[f.stage++], f.env);
+		return nullptr;
+	}
+
+	return f.last != nullptr ? f.last : __NULL;
+}
+
+Object *StackEvaluator::stepIf(size_t frame, Object *value)
+{
+	StackFrame &f = frames[frame];
+	IfExpression *ifExpr = (IfExpression *)f.node;
+
+	switch (f.stage)
+	{
+	case 0: // evaluate the condition
+		f.stage = 1;
+		push(ifExpr->condition, f.env);
+		return nullptr;
+
+	case 1: // pick a branch
+		f.stage = 2;
+
+		if (isTruthy(value))
+			push(ifExpr->consequence, f.env);
+		else if (ifExpr->alternative != nullptr)
+			push(ifExpr->alternative, f.env);
+		else
+			return __NULL;
+
+		return nullptr;
+
+	default: // branch done
+		return value;
+	}
+}
+
+Object *StackEvaluator::stepWhile(size_t frame, Object *value)
+{
+	StackFrame &f = frames[frame];
+	WhileExpression *whileExpr = (WhileExpression *)f.node;
+
+	if (f.stage == 1) // condition done
+	{
+		if (value->isError())
+			return value;
+
+		if (!isTruthy(value))
+			return __NULL;
+
+		f.stage = 2;
+		push(whileExpr->consequence, f.env);
+		return nullptr;
+	}
+
+	if (f.stage == 2) // body done
+	{
+		if (value->isError() || returning)
+			return value;
+	}
+
+	f.stage = 1;
+	push(whileExpr->condition, f.env);
+	return nullptr;
+}
+
+// Calls first evaluate callee and arguments like any other operands. A mod
+// function then gets its body pushed on top of the call frame, which stays
+// below it to receive the result. Tail calls replace the body in place.
+Object *StackEvaluator::stepCall(size_t frame, Object *value)
+{
+	StackFrame &f = frames[frame];
+
+	if (f.callee == nullptr)
+	{
+		if (value != nullptr)
+		{
+			if (value->isError())
+				return value;
+
+			f.values.push_back(value);
+		}
+
+		Node *next = operand(f, f.values.size());
+
+		if (next != nullptr)
+		{
+			push(next, f.env);
+			return nullptr;
+		}
+
+		Object *fn = f.values[0];
+
+		bool builtin;
+		Object *error = evaluator.checkCallee((CallExpression *)f.node, fn, builtin);
+
+		if (error != nullptr)
+			return error;
+
+		if (builtin)
+		{
+			Object *result = ((Builtin *)fn)->function(Arguments(f.values.data() + 1, f.values.size() - 1));
+
+			if (f.kind == FRAME_TAIL_CALL && !result->isError())
+				returning = true;
+
+			return result;
+		}
+
+		if (f.kind == FRAME_TAIL_CALL)
+		{
+			tailCall.call = (CallExpression *)f.node;
+			tailCall.function = (Function *)fn;
+			tailCall.args.assign(f.values.begin() + 1, f.values.end());
+			returning = true;
+			return __NULL;
+		}
+
+		std::vector<Object *> args(f.values.begin() + 1, f.values.end());
+
+		return enterFunction(frame, (Function *)fn, args, nullptr);
+	}
+
+	// the body returned
+	depth--;
+
+	returning = false;
+
+	if (tailCall.function != nullptr)
+	{
+		Function *fn = tailCall.function;
+		tailCall.function = nullptr;
+		return enterFunction(frame, fn, tailCall.args, f.calleeEnv);
+	}
+
+	evaluator.releaseFunctionEnv(f.calleeEnv);
+
+	return value;
+}
+
+Object *StackEvaluator::enterFunction(size_t frame, Function *fn, std::vector<Object *> &args, Environment *reuse)
+{
+	if (depth >= maxDepth)
+	{
+		overflow = new Error("error: maximum recursion depth exceeded -> " + std::to_string(maxDepth));
+		return overflow;
+	}
+
+	Environment *env;
+
+	if (reuse != nullptr)
+		env = evaluator.reuseFunctionEnv(fn, args, reuse);
+	else
+		env = evaluator.extendFunctionEnv(fn, args, fn->env);
+
+	frames[frame].callee = fn;
+	frames[frame].calleeEnv = env;
+	depth++;
+
+	push(fn->body, env);
+	return nullptr;
+}
+
+Object *StackEvaluator::stepOperands(size_t frame, Object *value)
+{
+	StackFrame &f = frames[frame];
+
+	if (value != nullptr)
+	{
+		if (value->isError())
+			return value;
+
+		f.values.push_back(value);
+	}
+
+	Node *next = operand(f, f.values.size());
+
+	if (next != nullptr)
+	{
+		push(next, f.env);
+		return nullptr;
+	}
+
+	return combine(f);
+}
+
+// i-th operand of the node, in the order Evaluator evaluates them, nullptr past the last
+Node *StackEvaluator::operand(StackFrame &frame, size_t i)
+{
+	Node *node = frame.node;
+
+	if (frame.kind == FRAME_CALL || frame.kind == FRAME_TAIL_CALL)
+	{
+		CallExpression *call = (CallExpression *)node;
+		if (i == 0)
+			return call->function;
+		return i - 1 < call->arguments.size() ? call->arguments[i - 1] : nullptr;
+	}
+
+	std::string nodeType = node->nodeType();
+	std::vector<Expression *> *list = nullptr;
+
+	if (nodeType == "ExpressionStatement")
+		return i == 0 ? ((ExpressionStatement *)node)->expression : nullptr;
+	else if (nodeType == "LetStatement")
+		return i == 0 ? ((LetStatement *)node)->value : nullptr;
+	else if (nodeType == "AssignStatement")
+	{
+		// a compound assignment only evaluates its right operand, the variable is read in place
+		InfixExpression *compound = ((AssignStatement *)node)->compound();
+		return i == 0 ? (compound != nullptr ? compound->right : ((AssignStatement *)node)->value) : nullptr;
+	}
+	else if (nodeType == "IndexAssignStatement")
+	{
+		IndexAssignStatement *stmt = (IndexAssignStatement *)node;
+		return i == 0 ? stmt->target->array : i == 1 ? stmt->target->index : i == 2 ? stmt->value : nullptr;
+	}
+	else if (nodeType == "ReturnStatement")
+		return i == 0 ? ((ReturnStatement *)node)->returnValue : nullptr;
+	else if (nodeType == "PrefixExpression")
+		return i == 0 ? ((PrefixExpression *)node)->right : nullptr;
+	else if (nodeType == "InfixExpression")
+		return i == 0 ? ((InfixExpression *)node)->left : i == 1 ? ((InfixExpression *)node)->right : nullptr;
+	else if (nodeType == "IndexExpression")
+		return i == 0 ? ((IndexExpression *)node)->array : i == 1 ? ((IndexExpression *)node)->index : nullptr;
+	else if (nodeType == "SliceExpression")
+	{
+		// a slice without an end has two operands
+		SliceExpression *slice = (SliceExpression *)node;
+		return i == 0 ? slice->array : i == 1 ? slice->start : i == 2 ? slice->end : nullptr;
+	}
+	else if (nodeType == "HashMapLiteral")
+	{
+		std::vector<HashMapPair> &pairs = ((HashMapLiteral *)node)->pairs;
+		if (i / 2 >= pairs.size())
+			return nullptr;
+		return i % 2 == 0 ? pairs[i / 2].key : pairs[i / 2].value;
+	}
+	else if (nodeType == "ArrayLiteral")
+		list = &((ArrayLiteral *)node)->elements;
+	else if (nodeType == "HashSetLiteral")
+		list = &((HashSetLiteral *)node)->pairs;
+	else if (nodeType == "StackLiteral")
+		list = &((StackLiteral *)node)->elements;
+	else if (nodeType == "QueueLiteral")
+		list = &((QueueLiteral *)node)->elements;
+	else if (nodeType == "DequeLiteral")
+		list = &((DequeLiteral *)node)->elements;
+	else if (nodeType == "MaxHeapLiteral")
+		list = &((MaxHeapLiteral *)node)->elements;
+	else if (nodeType == "MinHeapLiteral")
+		list = &((MinHeapLiteral *)node)->elements;
+
+	if (list != nullptr && i < list->size())
+		return (*list)[i];
+
+	return nullptr;
+}
+
+// what Evaluator::Eval does with the operands of the node once they are evaluated
+Object *StackEvaluator::combine(StackFrame &frame)
+{
+	Node *node = frame.node;
+	Environment *env = frame.env;
+	std::vector<Object *> &values = frame.values;
+	std::string nodeType = node->nodeType();
+
+	if (nodeType == "ExpressionStatement")
+		return values.empty() ? __NULL : values[0];
+
+	else if (nodeType == "LetStatement")
+		env->Set(((LetStatement *)node)->name.value, values[0]);
+
+	else if (nodeType == "AssignStatement" && ((AssignStatement *)node)->compound() != nullptr)
+	{
+		AssignStatement *stmt = (AssignStatement *)node;
+		Object *res = evaluator.evalCompoundAssignment(stmt->name.value, stmt->op, values[0], env);
+
+		if (res->isError())
+			return res;
+	}
+
+	else if (nodeType == "AssignStatement")
+	{
+		if (env->Lookup(((AssignStatement *)node)->name.value) == nullptr)
+			return new Error(ERROR_IDENTIFIER_NOT_FOUND, ((AssignStatement *)node)->name.value);
+
+		env->Set(((AssignStatement *)node)->name.value, values[0]);
+	}
+
+	else if (nodeType == "IndexAssignStatement")
+		return evaluator.evalIndexAssignment(values[0], values[1], values[2]);
+
+	else if (nodeType == "ReturnStatement")
+	{
+		returning = true;
+		return values[0];
+	}
+
+	else if (nodeType == "PrefixExpression")
+		return evaluator.evalPrefixExpression(((PrefixExpression *)node)->operand, values[0]);
+
+	else if (nodeType == "InfixExpression")
+		return evaluator.evalInfixExpression(((InfixExpression *)node)->operand, values[0], values[1]);
+
+	else if (nodeType == "IndexExpression")
+		return evaluator.evalIndexExpression(values[0], values[1], env);
+
+	else if (nodeType == "SliceExpression")
+		return evaluator.evalSliceExpression(values[0], values[1], values.size() > 2 ? values[2] : nullptr);
+
+	else if (nodeType == "ArrayLiteral")
+		return new Array(values);
+
+	else if (nodeType == "HashMapLiteral")
+	{
+		HashMap *hashMap = new HashMap();
+
+		for (size_t i = 0; i < values.size(); i += 2)
+			hashMap->pairs.set(HashKey(values[i]), values[i], values[i + 1]);
+
+		return hashMap;
+	}
+
+	else if (nodeType == "HashSetLiteral")
+	{
+		HashSet *hashSet = new HashSet();
+
+		for (auto key : values)
+			hashSet->pairs.set(HashKey(key), key, key);
+
+		return hashSet;
+	}
+
+	else if (nodeType == "StackLiteral")
+	{
+		Stack *stack = new Stack();
+
+		for (auto obj : values)
+			stack->elements.push(obj);
+
+		return stack;
+	}
+
+	else if (nodeType == "QueueLiteral")
+	{
+		Queue *queue = new Queue();
+
+		for (auto obj : values)
+			queue->elements.push(obj);
+
+		return queue;
+	}
+
+	else if (nodeType == "DequeLiteral")
+	{
+		Deque *deque = new Deque();
+
+		for (auto obj : values)
+			deque->elements.push_back(obj);
+
+		return deque;
+	}
+
+	else if (nodeType == "MaxHeapLiteral")
+	{
+		MaxHeap *maxHeap = new MaxHeap(((MaxHeapLiteral *)node)->type);
+
+		for (auto obj : values)
+			maxHeap->elements.push(obj);
+
+		return maxHeap;
+	}
+
+	else if (nodeType == "MinHeapLiteral")
+	{
+		MinHeap *minHeap = new MinHeap(((MinHeapLiteral *)node)->type);
+
+		for (auto obj : values)
+			minHeap->elements.push(obj);
+
+		return minHeap;
+	}
+
+	return __NULL;
+}
+
+Object *StackEvaluator::evalValue(Node *node, Environment *env)
+{
+	std::string nodeType = node->nodeType();
+
+	if (nodeType == "IntegerLiteral")
+	{
+		if (((IntegerLiteral *)node)->constant != nullptr)
+			return ((IntegerLiteral *)node)->constant;
+
+		return new Integer(((IntegerLiteral *)node)->value);
+	}
+
+	else if (nodeType == "BooleanLiteral")
+		return ((BooleanLiteral *)node)->value ? __TRUE : __FALSE;
+
+	else if (nodeType == "StringLiteral")
+		return new String(((StringLiteral *)node)->value);
+
+	else if (nodeType == "Identifier")
+		return evaluator.evalIdentifier((Identifier *)node, env);
+
+	else if (nodeType == "FunctionLiteral")
+		return evaluator.makeClosure((FunctionLiteral *)node, env);
+
+	return __NULL;
+}
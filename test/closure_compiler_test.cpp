@@ -0,0 +1,116 @@
+#include <iostream>
+#include <sstream>
+
+#include "../header/lexer.hpp"
+#include "../header/parser.hpp"
+#include "../header/evaluator.hpp"
+#include "../header/environment.hpp"
+#include "../header/closure_compiler.hpp"
+
+void TestClosureCompilerMatchesEvaluator();
+std::string runProgram(std::string input, bool compiled);
+
+int main()
+{
+	TestClosureCompilerMatchesEvaluator();
+}
+
+void TestClosureCompilerMatchesEvaluator()
+{
+	std::vector<std::string> tests = {
+		"5",
+		"-10 + 2 * 3 - 8 / 2 % 3",
+		"!true; !!5; !0",
+		"1 < 2; 2 <= 2; 3 > 4; 4 >= 5; 1 == 1; 1 != 1",
+		"\"foo\" + \"bar\"",
+		"let x = 10; x = x * 2; x",
+		"if (1 > 2) { 10 } else { 20 }",
+		"if (0) { 10 }",
+		"let i = 0; let sum = 0; while (i < 10) { sum = sum + i; i = i + 1; } sum",
+		"let add = def(a, b) { return a + b; }; add(2, 3)",
+		"let fib = def(n) { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); }; fib(15)",
+		"let adder = def(x) { def(y) { x + y } }; let addTwo = adder(2); addTwo(40)",
+		"let tripleCall = def(x, func) { func(func(func(x))); }; tripleCall(2, def(x) { x * x })",
+		"let f = def() { let i = 0; while (true) { if (i == 5) { return i; } i = i + 1; } }; f()",
+		"let arr = [1, \"two\", 3 * 4]; print(arr, arr[2], len(arr)); push(arr, 5); arr",
+		"let m = {1: \"one\", \"two\": 2}; print(m[1], m[\"two\"]); find(m, \"two\")",
+		"let s = hashset<> {1, 2, 2, \"x\"}; size(s)",
+		"let st = stack<> {1, 2, 3}; push(st, 4); st",
+		"let q = queue<> {1, 2}; push(q, 3); q",
+		"let d = deque<> {1, 2}; push_front(d, 0); d",
+		"let a = [1, 2, 3]; a[0] = 10; a[2] = a[0] + a[1]; let g = [[1], [2]]; g[1][0] = 9; print(g); a",
+		"let m = {}; let w = [\"a\", \"b\", \"a\"]; let i = 0; while (i < len(w)) { if (find(m, w[i])) { m[w[i]] = m[w[i]] + 1; } else { m[w[i]] = 1; } i = i + 1; } m",
+		"let d = deque<> {1, 2}; d[1] = 5; d[0] + d[1]",
+		"let a = [1]; a[1] = 2",
+		"let s = \"\"; let i = 0; while (i < 5) { s += \"ab\"; i += 1; } let t = s; s += \"!\"; print(t); s",
+		"let n = 10; n -= 3; n *= 4; n += 2; n",
+		"let s = \"hello, world\"; let a = [1, 2, 3, 4, 5]; let b = a[1:4]; b[0] = 9; print(s[0:5], s[7:], s[:5], a, b, b[1:]); a[1:][1:]",
+		"[1, 2][1:5]",
+		"let a = [5, -3, 9, 1, 7, 2, 8, 0, 4]; print(sum(a), min(a), max(a), find(a, 7), find(a, \"7\"), add(a, 1), mul(a, a[0:9])); a[0] = \"s\"; print(find(a, \"s\"), find(a, 9)); sub(a, 1)",
+		"min([])",
+		"let a = \"0123456789012345678901234567890123456789\"; let s = a + \"|\" + a; push(a, \"!\"); print(a); let i = 0; while (i < 3) { s = s + s; i = i + 1; } print(len(s), s[41]); s",
+		"let x = 1; x += \"a\"",
+		"let h = max_heap<int> {4, 9, 5}; h",
+		"let h = min_heap<str> {\"p\", \"m\", \"x\"}; h",
+		"\"hello\"[1]",
+		"print(1 / 0)",
+		"let x = 5; x(1)",
+		"let f = def(a) { a }; f(1, 2)",
+		"print(foo)",
+		"return 7; 8",
+		"let count = def(n, acc) { if (n == 0) { return acc; } return count(n - 1, acc + 1); }; count(100000, 0)",
+		"let f = def(n) { let g = def() { n }; if (n == 0) { return g(); } return f(n - 1); }; f(2000)",
+		"let f = def(a) { return def(b) { a + b }; }; f(1)(2)",
+	};
+
+	int failures = 0;
+
+	for (auto test : tests)
+	{
+		std::string expected = runProgram(test, false);
+		std::string got = runProgram(test, true);
+
+		if (expected != got)
+		{
+			failures++;
+			std::cout << "closure tier mismatch for: " << test << std::endl
+					  << "  evaluator: " << expected << std::endl
+					  << "  compiled : " << got << std::endl;
+		}
+	}
+
+	std::cout << "closure compiler: " << tests.size() - failures << "/" << tests.size() << " programs match" << std::endl;
+}
+
+std::string runProgram(std::string input, bool compiled)
+{
+	Lexer lexer;
+	lexer.New(input);
+
+	Parser parser;
+	parser.New(lexer);
+
+	Program *program = parser.ParseProgram();
+	Environment *env = new Environment();
+
+	// capture whatever the builtins print alongside the final value
+	std::stringstream out;
+	std::streambuf *old = std::cout.rdbuf(out.rdbuf());
+
+	Object *obj;
+
+	if (compiled)
+	{
+		ClosureCompiler compiler;
+		obj = compiler.Run(compiler.Compile(program), env);
+	}
+	else
+	{
+		Evaluator evaluator;
+		obj = evaluator.Eval(program, env);
+	}
+
+	std::cout.rdbuf(old);
+
+	return out.str() + obj->inspect();
+}
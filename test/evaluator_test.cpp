@@ -1,17 +1,60 @@
 #include <iostream>
+#include <chrono>
 
 #include "../header/lexer.hpp"
 #include "../header/parser.hpp"
 #include "../header/evaluator.hpp"
 #include "../header/environment.hpp"
+#include "../header/resolver.hpp"
+#include "../header/optimizer.hpp"
 
 void TestEvalIntegerExpression();
-Object *testEval(std::string input);
+void TestTailCalls();
+void TestReturns();
+void TestBuiltinResolution();
+void TestErrorHandling();
+void TestCallSiteCache();
+void TestFramePool();
+void TestClosureCaptures();
+void TestLargeScopes();
+void TestConstantFolding();
+void TestInlining();
+void TestHashKeys();
+void TestHashTable();
+void TestHashTableModes();
+void TestIndexAssignment();
+void TestIndexCost();
+void TestCompoundAssignment();
+void TestStringConcatenation();
+void TestSlices();
+void TestPackedArrays();
+Object *testEval(std::string input, bool resolve = false);
+double timeEval(std::string label, std::string input, Environment *env = nullptr, Object **result = nullptr);
+Program *parse(std::string input);
 void testIntegerObject(Object *obj, int expected);
 
 int main()
 {
 	TestEvalIntegerExpression();
+	TestTailCalls();
+	TestReturns();
+	TestBuiltinResolution();
+	TestErrorHandling();
+	TestCallSiteCache();
+	TestFramePool();
+	TestClosureCaptures();
+	TestLargeScopes();
+	TestConstantFolding();
+	TestInlining();
+	TestHashKeys();
+	TestHashTable();
+	TestHashTableModes();
+	TestIndexAssignment();
+	TestIndexCost();
+	TestCompoundAssignment();
+	TestStringConcatenation();
+	TestSlices();
+	TestPackedArrays();
 }
 
 void TestEvalIntegerExpression()
@@ -28,7 +71,900 @@ void TestEvalIntegerExpression()
 	}
 }
 
-Object *testEval(std::string input)
+void TestTailCalls()
+{
+	// deep enough to overflow the native stack without tail calls
+	std::vector<std::pair<std::string, int>> tests = {
+		{"let count = def(n, acc) { if (n == 0) { return acc; } return count(n - 1, acc + 1); }; count(200000, 0)", 200000},
+		{"let even = def(n) { if (n == 0) { return 1; } return odd(n - 1); }; let odd = def(n) { if (n == 0) { return 0; } return even(n - 1); }; even(100001)", 0},
+		{"let f = def(n) { let g = def() { n }; if (n == 0) { return g(); } return f(n - 1); }; f(20000)", 0},
+		{"let f = def(n) { let i = 0; while (true) { if (i == 3) { return g(n, i); } i = i + 1; } }; let g = def(a, b) { a * b }; f(7)", 21},
+		{"let f = def(n) { if (n == 0) { return len(\"abc\"); } return f(n - 1); }; f(50000)", 3},
+	};
+
+	for (auto test : tests)
+	{
+		Object *obj = testEval(test.first);
+		testIntegerObject(obj, test.second);
+	}
+}
+
+void TestReturns()
+{
+	// a return stops its own function and program only, the caller goes on
+	std::vector<std::pair<std::string, int>> tests = {
+		{"return 4; 5", 4},
+		{"let f = def() { let i = 0; while (true) { while (true) { if (i == 2) { return i; } i = i + 1; } } }; f() + 1", 3},
+		{"let f = def(n) { if (n > 0) { return n; } 0 }; let a = f(3); let b = f(0); a * 10 + b", 30},
+		{"let f = def() { return 1; }; let g = def() { f(); 2 }; g()", 2},
+		{"let f = def(n) { return len(\"ab\") + n; }; f(1); f(2)", 4},
+	};
+
+	for (auto test : tests)
+	{
+		testIntegerObject(testEval(test.first), test.second);
+		testIntegerObject(testEval(test.first, true), test.second);
+	}
+}
+
+void TestBuiltinResolution()
+{
+	// bindings shadow builtins the same with and without the Resolver
+	std::vector<std::pair<std::string, int>> tests = {
+		{"let f = def(s) { len(s) }; f(\"abcd\")", 4},
+		{"let len = def(x) { 42 }; len(\"ab\")", 42},
+		{"let f = def(len) { len + 1 }; f(4)", 5},
+		{"let f = def() { len(\"abc\") }; let g = f(); let len = def(x) { 7 }; g + f()", 10},
+		{"let f = def() { let print = 3; print }; f()", 3},
+		{"let f = def() { if (true) { let size = 2; } size }; f()", 2},
+	};
+
+	for (auto test : tests)
+	{
+		testIntegerObject(testEval(test.first, false), test.second);
+		testIntegerObject(testEval(test.first, true), test.second);
+	}
+
+	// builtin arity is checked when the call is resolved, the error still only happens when it runs
+	std::vector<std::pair<std::string, std::string>> errors = {
+		{"let f = def() { pop([1], 2) }; 1; f()", "error: argument length (2) not equal to parameter length (1)"},
+		{"let s = stack<> {1}; push(s); 1", "error: argument length (1) not equal to parameter length (2)"},
+		{"insert()", "error: argument length (0) not equal to parameter length (2)"},
+	};
+
+	for (auto test : errors)
+	{
+		for (bool resolve : {false, true})
+		{
+			Object *obj = testEval(test.first, resolve);
+			std::cout << obj->inspect() << std::endl;
+
+			if (obj->inspect() != test.second)
+				std::cout << "error has wrong message, got=" << obj->inspect() << " want=" << test.second << std::endl;
+		}
+	}
+
+	// more arguments than fit on the native stack
+	testIntegerObject(testEval("let f = def(a, b, c, d, e, g) { a + b + c + d + e + g }; print(1, 2, 3, 4, 5, 6); f(1, 2, 3, 4, 5, 6)", true), 21);
+
+	// REPL lines are resolved one by one against the same environment, a global
+	// let on a later line shadows the builtin for functions of earlier lines too
+	std::vector<std::pair<std::string, int>> lines = {
+		{"let f = def(s) { len(s) }; f(\"ab\")", 2},
+		{"let len = def(x) { 42 }; len(\"ab\")", 42},
+		{"f(\"ab\")", 42},
+	};
+
+	Environment *env = new Environment();
+	Evaluator evaluator;
+	Resolver resolver;
+
+	for (auto line : lines)
+	{
+		Program *program = parse(line.first);
+		resolver.Resolve(program, env);
+		testIntegerObject(evaluator.Eval(program, env), line.second);
+	}
+}
+
+void TestErrorHandling()
+{
+	// an error stops the program and its message is only built when printed
+	std::vector<std::pair<std::string, std::string>> tests = {
+		{"foo; 5", "error : identifier not found -> foo"},
+		{"x = 3; 5", "error : identifier not found -> x"},
+		{"let f = def(n) { n + true }; let g = def() { f(1); 5 }; g()", "error: type mismatch -> INTEGER + BOOLEAN"},
+		{"let f = def(a) { a }; f(1, 2)", "error: argument length (2) not equal to parameter length (1)"},
+		{"5(1)", "error: not a function -> INTEGER"},
+		{"[1, 2][5]", "error: index 5 out of range"},
+		{"len(1, 2)", "error: argument length (2) not equal to parameter length (1)"},
+		{"let i = 0; while (true) { i = i + 1; if (i == 3) { i + \"a\"; } }", "error: type mismatch -> INTEGER + STRING"},
+	};
+
+	for (auto test : tests)
+	{
+		Object *obj = testEval(test.first);
+
+		if (!obj->isError())
+		{
+			std::cout << "object is not Error, got=" << obj->type() << std::endl;
+			continue;
+		}
+
+		std::cout << obj->inspect() << std::endl;
+
+		if (obj->inspect() != test.second)
+			std::cout << "error has wrong message, got=" << obj->inspect() << " want=" << test.second << std::endl;
+	}
+
+	// builtins that mutate in place
+	testIntegerObject(testEval("let a = [1, 2, 3]; pop(a); len(a)"), 2);
+	testIntegerObject(testEval("let d = deque<> {1}; push_back(d, 2); push_back(d, 3); size(d)"), 3);
+}
+
+void TestCallSiteCache()
+{
+	// the call in apply sees functions, builtins and closures, more than its cache holds
+	std::string apply = "let apply = def(f, x) { f(x) }; let inc = def(x) { x + 1 }; let dbl = def(x) { x * 2 }; "
+						"let adder = def(n) { def(x) { x + n } }; ";
+
+	std::vector<std::pair<std::string, int>> tests = {
+		{apply + "apply(inc, 1) + apply(dbl, 2) + apply(len, \"abc\")", 9},
+		{apply + "let s = 0; let i = 0; while (i < 10) { s = s + apply(adder(i), 0); i = i + 1; } s", 45},
+		{apply + "apply(inc, 1); apply(adder(1), 1); apply(adder(2), 1); apply(dbl, 1); apply(adder(3), 1); apply(inc, 5)", 6},
+		{apply + "let sq = def(x) { x * x }; apply(inc, 1); let inc = sq; apply(inc, 5)", 25},
+	};
+
+	for (auto test : tests)
+		testIntegerObject(testEval(test.first), test.second);
+
+	// a cached callee does not let another one skip its checks
+	std::vector<std::pair<std::string, std::string>> errors = {
+		{apply + "apply(inc, 1); apply(def(a, b) { a }, 1)", "error: argument length (1) not equal to parameter length (2)"},
+		{apply + "apply(len, \"a\"); apply(5, 1)", "error: not a function -> INTEGER"},
+	};
+
+	for (auto test : errors)
+	{
+		Object *obj = testEval(test.first);
+		std::cout << obj->inspect() << std::endl;
+
+		if (obj->inspect() != test.second)
+			std::cout << "error has wrong message, got=" << obj->inspect() << " want=" << test.second << std::endl;
+	}
+}
+
+void TestFramePool()
+{
+	// frames handed out again keep nothing of the call that used them before
+	std::vector<std::pair<std::string, int>> tests = {
+		{"let fib = def(n) { if (n < 2) { return n; } fib(n - 1) + fib(n - 2) }; fib(15)", 610},
+		{"let mk = def(n) { let g = def() { n }; g }; let a = mk(1); let sq = def(x) { x * x }; sq(5); let b = mk(2); sq(6); a() * 10 + b()", 12},
+		{"let f = def(n) { let t = n * 2; t }; let g = def(n) { if (n > 0) { let t = 100; } f(n) + n }; g(1) + g(0)", 3},
+	};
+
+	for (auto test : tests)
+		testIntegerObject(testEval(test.first), test.second);
+
+	Object *obj = testEval("let f = def(n) { if (n == 0) { return x; } let x = n; f(n - 1) }; f(0); f(3)");
+	std::cout << obj->inspect() << std::endl;
+
+	if (obj->inspect() != "error : identifier not found -> x")
+		std::cout << "error has wrong message, got=" << obj->inspect() << std::endl;
+}
+
+void TestClosureCaptures()
+{
+	// closures see their variables the way the enclosing frames bind them, also later
+	std::vector<std::pair<std::string, int>> tests = {
+		{"let f = def() { let g = def() { x }; let x = 5; g() }; f()", 5},
+		{"let f = def() { let loop = def(n) { if (n == 0) { return 0; } 1 + loop(n - 1) }; loop(10) }; f()", 10},
+		{"let a = def(x) { def(y) { def(z) { x * 100 + y * 10 + z } } }; a(1)(2)(3)", 123},
+		{"let f = def() { let x = 1; let g = def() { x }; x = 2; g() }; f()", 2},
+		{"let f = def() { let v = 1; let mid = def() { def() { v } }; let i = mid(); v = 5; i() }; f()", 5},
+		{"let x = 42; let f = def(b) { let g = def() { x }; if (b) { let x = 9; } g() }; f(false) * 10 + f(true) - 420", 9},
+		// a captured name the closure assigns becomes a binding of its own frame
+		{"let f = def() { let c = 0; let inc = def() { c = c + 1; c }; inc() * 10 + inc() * 100 + c }; f()", 110},
+		{"let f = def(a, b) { def() { b * 10 + a } }; let g = f(1, 2); let h = f(3, 4); g() * 100 + h()", 2143},
+	};
+
+	for (auto test : tests)
+		testIntegerObject(testEval(test.first), test.second);
+
+	// the closure keeps n, not the array or the rest of the frame chain
+	Object *obj = testEval("let mk = def(m) { let big = [1, 2, 3]; let n = 4; def() { n + len(\"a\") } }; mk(1)");
+
+	if (obj->type() != FUNCTION_OBJ)
+		std::cout << "object is not Function, got=" << obj->type() << std::endl;
+	else
+	{
+		Environment *env = ((Function *)obj)->env;
+		std::cout << env->store.size() << std::endl;
+
+		if (env->store.size() != 1 || env->store.find("n") == nullptr)
+			std::cout << "closure captured more than n, got=" << env->store.size() << " bindings" << std::endl;
+
+		// and reads it by its position among the captures
+		ExpressionStatement *stmt = (ExpressionStatement *)((Function *)obj)->body->statements[0];
+		Identifier *n = (Identifier *)((InfixExpression *)stmt->expression)->left;
+
+		if (env->cells.size() != 1 || n->capture != 0)
+			std::cout << "captured n not read by position, got=" << n->capture << std::endl;
+	}
+}
+
+void TestLargeScopes()
+{
+	// scopes with more bindings than fit inline move to a hash table on the way
+	std::string lets;
+	std::string sum = "0";
+
+	for (int i = 0; i < 12; i++)
+	{
+		std::string name = std::string("v") + (char)('a' + i);
+
+		lets += "let " + name + " = " + std::to_string(i) + "; ";
+		sum += " + " + name;
+	}
+
+	std::vector<std::pair<std::string, int>> tests = {
+		{lets + sum, 66},
+		{"let f = def(a) { " + lets + "vd = 30; a + " + sum + " }; f(100) + f(0)", 100 + 2 * 93},
+		{"let f = def(n) { " + lets + "if (n == 0) { return vl; } f(n - 1) + va }; f(3) + f(3)", 22},
+	};
+
+	for (auto test : tests)
+		testIntegerObject(testEval(test.first), test.second);
+
+	// just below, at and past the inline capacity, every binding is found and
+	// updated in place, also the ones added before the move to the table
+	for (int size = ENV_INLINE_BINDINGS - 1; size <= ENV_INLINE_BINDINGS + 2; size++)
+	{
+		Bindings bindings;
+
+		for (int i = 0; i < size; i++)
+			bindings.add("b" + std::to_string(i), new Integer(i));
+
+		for (int i = 0; i < size; i++)
+			*bindings.find("b" + std::to_string(i)) = new Integer(i * 10);
+
+		for (int i = 0; i < size; i++)
+		{
+			Object **slot = bindings.find("b" + std::to_string(i));
+
+			if (slot == nullptr || ((Integer *)*slot)->value != i * 10)
+				std::cout << "binding b" << i << " of " << size << " wrong after update" << std::endl;
+		}
+
+		if (bindings.size() != (size_t)size || bindings.keys().size() != (size_t)size || bindings.find("b" + std::to_string(size)) != nullptr)
+			std::cout << "wrong bindings, got size=" << bindings.size() << " want=" << size << std::endl;
+
+		bindings.clear();
+		bindings.add("x", __NULL);
+
+		if (bindings.size() != 1 || bindings.find("b0") != nullptr || bindings.find("x") == nullptr)
+			std::cout << "bindings not cleared, got size=" << bindings.size() << std::endl;
+	}
+}
+
+void TestConstantFolding()
+{
+	// source of the program as the Optimizer should leave it, and what it evaluates to
+	struct FoldTest
+	{
+		std::string input;
+		std::string optimized;
+		int expected;
+	};
+
+	std::vector<FoldTest> tests = {
+		{"60 * 60 * 24", "86400", 86400},
+		{"let x = 3; x * (2 + 5)", "let x = 3; x * 7", 21},
+		{"if (!(2 > 3)) { 5 + 1 } else { 0 }", "if (true) { 6 } else { 0 }", 6},
+		{"let f = def(n) { let m = n; m + 2 * 3 }; f(1)", "let f = def(n) { let m = n; m + 6 }; f(1)", 7},
+		{"let d = 0; if (d == 0) { 1 } else { 10 / 0 }", "let d = 0; if (d == 0) { 1 } else { 10 / 0 }", 1},
+		{"let i = 0; while (i < 2 + 3) { i = i + 1; } i", "let i = 0; while (i < 5) { i = i + 1; } i", 5},
+		{"len(\"ab\" + \"cd\") + [1 + 1][0]", "len(\"abcd\") + [2][0]", 6},
+	};
+
+	for (auto test : tests)
+	{
+		Program *program = parse(test.input);
+
+		Optimizer optimizer;
+		optimizer.Optimize(program);
+
+		std::string want = parse(test.optimized)->getStringRepr();
+
+		if (program->getStringRepr() != want)
+			std::cout << "program not folded as expected, got=" << program->getStringRepr() << " want=" << want << std::endl;
+
+		Evaluator evaluator;
+		testIntegerObject(evaluator.Eval(program, new Environment()), test.expected);
+	}
+}
+
+void TestInlining()
+{
+	std::string helpers = "let add = def(a, b) { return a + b; }; let sq = def(x) { x * x }; ";
+
+	std::vector<std::pair<std::string, std::string>> inlined = {
+		{helpers + "add(1, 2)", "inline add(1, 2) => 3"},
+		{helpers + "let y = 2; sq(y)", "inline sq(y) => (y*y)"},
+		{helpers + "let y = 2; add(y * 3, 1)", "inline add((y*3), 1) => ((y*3)+1)"},
+	};
+
+	// calls that must stay calls
+	std::vector<std::string> kept = {
+		helpers + "let y = 2; sq(y + 1)",				 // argument would be evaluated twice
+		helpers + "let f = def(add) { add(1, 2) }; 0",	 // shadowed by a parameter
+		helpers + "add = def(a, b) { a - b }; add(1, 2)", // assigned
+		helpers + "let t = def(n) { len(n) }; add(t(\"ab\"), 1)", // argument calls a function
+	};
+
+	for (auto test : inlined)
+	{
+		Program *program = parse(test.first);
+		Optimizer optimizer;
+		optimizer.Optimize(program);
+
+		std::string last = program->statements.back()->getStringRepr();
+		std::cout << last << std::endl;
+
+		if (last.find(test.second) == std::string::npos)
+			std::cout << "call not inlined, got=" << last << " want=" << test.second << std::endl;
+	}
+
+	for (auto input : kept)
+	{
+		Program *program = parse(input);
+		Optimizer optimizer;
+		optimizer.Optimize(program);
+
+		if (program->getStringRepr().find("inline") != std::string::npos)
+			std::cout << "call should not be inlined -> " << program->getStringRepr() << std::endl;
+	}
+
+	// a later program rebinding the function makes the inlined call fall back to a real one
+	Environment *env = new Environment();
+	Evaluator evaluator;
+	Optimizer optimizer;
+
+	Program *first = parse("let add = def(a, b) { a + b }; let use = def(x) { add(x, 1) }; use(5)");
+	optimizer.Optimize(first);
+	testIntegerObject(evaluator.Eval(first, env), 6);
+
+	Program *second = parse("let add = def(a, b) { a * b }; use(5)");
+	optimizer.Optimize(second);
+	testIntegerObject(evaluator.Eval(second, env), 5);
+}
+
+void TestHashKeys()
+{
+	std::string longKey = "\"" + std::string(70, 'k') + "\"";
+
+	// keys are equal by type and value, not by object or by their text
+	std::vector<std::pair<std::string, int>> tests = {
+		{"let m = {1: 10, \"1\": 20, true: 30}; m[1] + m[\"1\"] + m[true]", 60},
+		{"let m = {\"ab\": 1}; m[\"a\" + \"b\"]", 1},
+		{"let m = {}; let k = \"key\"; insert(m, k, 1); insert(m, \"ke\" + \"y\", 2); m[k]", 1},
+		{"let s = hashset<> {1, \"1\", true, false, 0}; size(s)", 5},
+		{"let s = hashset<> {[1, 2], [1, 2], [2, 1]}; size(s)", 2},
+		{"let m = {-5: 1, 5: 2}; remove(m, -5); if (find(m, -5)) { 0 } else { m[5] }", 2},
+		// a string changed in place after it became a key leaves the key as it was
+		{"let k = \"ab\"; let m = {}; insert(m, k, 1); push(k, \"c\"); if (find(m, k)) { 0 } else { m[\"ab\"] }", 1},
+		{"let k = \"xy\"; let s = hashset<> {}; insert(s, k); pop(k); if (find(s, k)) { 0 } else { if (find(s, \"xy\")) { 1 } else { 2 } }", 1},
+		{"let k = \"q\"; k += \"w\"; let m = {}; m[k] = 5; k += \"r\"; if (find(m, k)) { 0 } else { m[\"qw\"] }", 5},
+		{"let k = " + longKey + "; let m = {}; m[k] = 7; push(k, \"r\"); m[" + longKey + "] * 10 + len(m)", 71},
+		{"let k = \"ab\"; let m = {}; m[k] = 1; m[k] = 2; push(k, \"c\"); len(k) * 10 + m[\"ab\"]", 32},
+	};
+
+	for (auto test : tests)
+		testIntegerObject(testEval(test.first), test.second);
+
+	// replacing the value of a key keeps the key the entry stored first
+	HashTable table;
+	String *first = new String("key");
+	String *second = new String("key");
+
+	table.set(HashKey(first), first, new Integer(1));
+	Object *stored = table.find(HashKey(first))->key;
+	table.set(HashKey(second), second, new Integer(2));
+
+	HashEntry *entry = table.find(HashKey(second));
+
+	if (entry->key != stored)
+		std::cout << "replacing a value stored its key again" << std::endl;
+
+	testIntegerObject(entry->value, 2);
+}
+
+void TestHashTable()
+{
+	// enough entries to grow the table several times, removals shift the
+	// entries after them back so every remaining key is still found
+	std::string fill = "let m = {}; let s = hashset<> {-1}; let i = 0; "
+					   "while (i < 5000) { insert(m, i * 7, i); insert(s, i / 2); i = i + 1; } "
+					   "i = 0; while (i < 5000) { if (i / 3 * 3 == i) { remove(m, i * 7); } i = i + 1; } ";
+
+	std::vector<std::pair<std::string, int>> tests = {
+		{fill + "len(m)", 3333},
+		{fill + "size(s)", 2501},
+		{fill + "let t = 0; i = 0; while (i < 5000) { if (find(m, i * 7)) { t = t + m[i * 7]; } i = i + 1; } t", 8331667},
+		{fill + "i = 0; while (i < 5000) { insert(m, i * 7, 0); i = i + 1; } len(m)", 5000},
+		{"let m = {\"a\": 1, \"b\": 2, \"a\": 3}; m[\"a\"] * 10 + len(m)", 32},
+	};
+
+	for (auto test : tests)
+		testIntegerObject(testEval(test.first), test.second);
+
+	// entries are kept and printed in insertion order, replacing a value keeps its place
+	std::vector<std::pair<std::string, std::string>> orders = {
+		{"{\"b\": 1, \"a\": 2, 3: true}", "{b : 1, a : 2, 3 : true}"},
+		{"let m = {\"b\": 1, \"a\": 2, \"c\": 3}; remove(m, \"b\"); insert(m, \"b\", 4); m", "{a : 2, c : 3, b : 4}"},
+		{"{2: 0, 1: 0, 2: 5}", "{2 : 5, 1 : 0}"},
+		{"let s = hashset<> {5, 3, 9}; remove(s, 3); insert(s, 1); s", "hashset<> {5, 9, 1}"},
+		{fill + "let k = {}; i = 4998; while (i < 5000) { if (find(m, i * 7)) { insert(k, i, m[i * 7]); } i = i + 1; } k", "{4999 : 4999}"},
+	};
+
+	for (auto test : orders)
+	{
+		std::string got = testEval(test.first)->inspect();
+		std::cout << got << std::endl;
+
+		if (got != test.second)
+			std::cout << "wrong order, got=" << got << " want=" << test.second << std::endl;
+	}
+
+	// the index was rebuilt and compacted many times on the way
+	std::string printed = testEval(fill + "m")->inspect();
+
+	if (printed.compare(0, 14, "{7 : 1, 14 : 2") != 0)
+		std::cout << "wrong order, got=" << printed.substr(0, 14) << std::endl;
+}
+
+void TestHashTableModes()
+{
+	std::string counting = "let m = {}; let i = 0; while (i < 1000) { insert(m, i, i * 2); i = i + 1; } ";
+
+	struct ModeTest
+	{
+		std::string input;
+		HashTableMode mode;
+		std::string check; // evaluated after input, must give 1
+	};
+
+	std::vector<ModeTest> tests = {
+		{"let m = {\"a\": 1, 2: 3}; ", HASH_TABLE_SMALL, "m[\"a\"] + m[2] == 4"},
+		{counting, HASH_TABLE_DENSE, "m[0] + m[999] == 1998"},
+		{counting + "i = 0; while (i < 1000) { if (i > 2) { remove(m, i); } i = i + 1; } insert(m, 1, 5); ", HASH_TABLE_DENSE,
+		 "len(m) == 3"},
+		{counting + "i = 0; while (i < 990) { remove(m, i); i = i + 1; } i = 0; while (i < 40) { insert(m, i, 1); i = i + 1; } ",
+		 HASH_TABLE_DENSE, "len(m) == 50"},
+		{counting + "insert(m, \"x\", 7); ", HASH_TABLE_HASHED, "m[\"x\"] + m[500] == 1007"},
+		{counting + "insert(m, -1, 7); ", HASH_TABLE_HASHED, "m[-1] + m[999] == 2005"},
+		{"let m = {0: 0, 1: 0, 2: 0, 3: 0, 4: 0, 5: 0, 6: 0, 7: 0}; insert(m, 100, 1); ", HASH_TABLE_HASHED, "m[100] == 1"},
+		{"let m = {0: 0, 1: 0, 2: 0, 3: 0, 4: 0, 5: 0, 6: 0, 7: 0}; insert(m, 8, 1); ", HASH_TABLE_DENSE, "m[8] == 1"},
+	};
+
+	for (auto test : tests)
+	{
+		Object *map = testEval(test.input + "m");
+		HashTableMode mode = ((HashMap *)map)->pairs.Mode();
+
+		if (mode != test.mode)
+			std::cout << "wrong table mode, got=" << mode << " want=" << test.mode << std::endl;
+
+		Object *check = testEval(test.input + "if (" + test.check + ") { 1 } else { 0 }");
+		testIntegerObject(check, 1);
+	}
+
+	// changing the mode keeps the insertion order
+	std::string printed = testEval("let m = {3: 0, 1: 0, 2: 0, 0: 0, 4: 0, 5: 0, 6: 0, 7: 0}; insert(m, 8, 0); remove(m, 1); "
+								   "insert(m, \"s\", 0); m")
+							  ->inspect();
+	std::cout << printed << std::endl;
+
+	if (printed != "{3 : 0, 2 : 0, 0 : 0, 4 : 0, 5 : 0, 6 : 0, 7 : 0, 8 : 0, s : 0}")
+		std::cout << "wrong order, got=" << printed << std::endl;
+}
+
+void TestIndexAssignment()
+{
+	std::vector<std::pair<std::string, int>> tests = {
+		{"let a = [1, 2, 3]; a[1] = 20; a[0] + a[1] + a[2]", 24},
+		{"let a = [1, 2]; let b = a; b[0] = 5; a[0]", 5},
+		{"let set = def(arr, i, v) { arr[i] = v; }; let a = [0, 0]; set(a, 1, 7); a[1]", 7},
+		{"let g = [[1, 2], [3, 4]]; g[1][1] = 40; g[1][1] + g[0][1]", 42},
+		{"let m = {\"a\": 1}; m[\"a\"] = m[\"a\"] + 1; m[\"b\"] = 10; m[\"a\"] + m[\"b\"] + len(m)", 14},
+		{"let m = {}; let i = 0; while (i < 100) { m[i / 10] = i; i = i + 1; } len(m) * 1000 + m[9]", 10099},
+		{"let d = deque<> {1, 2, 3}; d[2] = 30; d[0] + d[2]", 31},
+	};
+
+	for (auto test : tests)
+	{
+		testIntegerObject(testEval(test.first), test.second);
+		testIntegerObject(testEval(test.first, true), test.second);
+	}
+
+	std::vector<std::pair<std::string, std::string>> errors = {
+		{"let a = [1]; a[1] = 2", "error: index 1 out of range"},
+		{"let a = [1]; a[-1] = 2", "error: index -1 out of range"},
+		{"let s = \"ab\"; s[0] = \"c\"", "error: index assignment not supported for -> STRING[INTEGER]"},
+		{"b[0] = 1", "error : identifier not found -> b"},
+	};
+
+	for (auto test : errors)
+	{
+		std::string got = testEval(test.first)->inspect();
+		std::cout << got << std::endl;
+
+		if (got != test.second)
+			std::cout << "wrong error, got=" << got << " want=" << test.second << std::endl;
+	}
+
+	// the statement is printed back the way it was written
+	std::string printed = parse("a[i + 1] = m[\"k\"];")->statements[0]->getStringRepr();
+
+	if (printed != "a[(i+1)] = m[k];")
+		std::cout << "wrong index assignment, got=" << printed << std::endl;
+}
+
+void TestIndexCost()
+{
+	// indexing reads the container in place, a copy per access would make the
+	// large ones thousands of times slower; the times are printed to compare
+	std::vector<std::pair<int, std::string>> kinds = {{0, "array"}, {1, "string"}, {2, "hashmap"}};
+
+	for (auto kind : kinds)
+	{
+		int sizes[2] = {16, 1000000};
+
+		for (int s = 0; s < 2; s++)
+		{
+			Object *c;
+
+			if (kind.first == 0)
+			{
+				std::vector<Object *> elements;
+
+				for (int i = 0; i < sizes[s]; i++)
+					elements.push_back(new Integer(i));
+
+				c = new Array(elements);
+			}
+			else if (kind.first == 1)
+				c = new String(std::string(sizes[s], 'x'));
+			else
+			{
+				HashMap *hashMap = new HashMap();
+
+				for (int i = 0; i < sizes[s]; i++)
+				{
+					Object *key = new Integer(i);
+					hashMap->pairs.set(HashKey(key), key, key);
+				}
+
+				c = hashMap;
+			}
+
+			Environment *env = new Environment();
+			env->Set("c", c);
+
+			std::string found = kind.first == 1 ? "\"x\"" : "9";
+			Object *result;
+			timeEval(kind.second + " indexing, size " + std::to_string(sizes[s]),
+					 "let i = 0; while (i < 20000) { c[9]; find(c, " + found + "); i = i + 1; } i", env, &result);
+			testIntegerObject(result, 20000);
+		}
+	}
+}
+
+// Program building a string of n pieces with the statement append, which adds
+// "abcdefgh" to s, and evaluating to its length
+std::string appendingProgram(int n, std::string append)
+{
+	return "let s = \"\"; let i = 0; while (i < " + std::to_string(n) + ") { " + append + " i += 1; } len(s)";
+}
+
+void TestCompoundAssignment()
+{
+	std::vector<std::pair<std::string, int>> tests = {
+		{"let x = 5; x += 3; x -= 1; x *= 6; x", 42},
+		{"let x = 2; x *= 3 + 4; x", 14},
+		{"let f = def(n) { let acc = 0; let i = 1; while (i <= n) { acc += i; i += 1; } acc }; f(100)", 5050},
+		{"let s = \"\"; let i = 0; while (i < 10) { s += \"ab\"; i += 1; } len(s)", 20},
+		{"let s = \"\"; s += s; s += \"ab\"; s += s; len(s)", 4},
+		// the string stops growing in place once anything else can see it
+		{"let s = \"ab\"; let t = s; s += \"c\"; len(t) * 10 + len(s)", 23},
+		{"let s = \"\"; s += \"ab\"; let t = s; s += \"c\"; len(t) * 10 + len(s)", 23},
+		{"let s = \"\"; s += \"a\"; let keep = [s]; s += \"b\"; len(keep[0])", 1},
+		{"let s = \"\"; s += \"a\"; let f = def() { s }; let t = f(); s += \"b\"; len(t) * 10 + len(f())", 12},
+		{"let k = \"\"; k += \"ab\"; let m = {}; m[k] = 1; k += \"c\"; m[\"ab\"] + len(m)", 2},
+	};
+
+	for (auto test : tests)
+	{
+		testIntegerObject(testEval(test.first), test.second);
+		testIntegerObject(testEval(test.first, true), test.second);
+	}
+
+	std::vector<std::pair<std::string, std::string>> errors = {
+		{"let x = 1; x += \"a\"", "error: type mismatch -> INTEGER + STRING"},
+		{"let s = \"a\"; s -= \"a\"", "error: unknown operator -> STRING - STRING"},
+		{"y += 1", "error : identifier not found -> y"},
+	};
+
+	for (auto test : errors)
+	{
+		std::string got = testEval(test.first)->inspect();
+		std::cout << got << std::endl;
+
+		if (got != test.second)
+			std::cout << "wrong error, got=" << got << " want=" << test.second << std::endl;
+	}
+
+	std::string printed = parse("total += a[i] * 2;")->statements[0]->getStringRepr();
+
+	if (printed != "total += (a[i]*2);")
+		std::cout << "wrong compound assignment, got=" << printed << std::endl;
+
+	// appending in place keeps building a string linear, copying it on every
+	// += would make four times the pieces take sixteen times as long
+	Object *result;
+	timeEval("appending, 20000 pieces", appendingProgram(20000, "s += \"abcdefgh\";"), nullptr, &result);
+	testIntegerObject(result, 20000 * 8);
+
+	timeEval("appending, 80000 pieces", appendingProgram(80000, "s += \"abcdefgh\";"), nullptr, &result);
+	testIntegerObject(result, 80000 * 8);
+}
+
+void TestStringConcatenation()
+{
+	std::string piece = "\"" + std::string(70, 'x') + "\"";
+
+	std::vector<std::pair<std::string, int>> tests = {
+		{"let s = \"ab\" + \"cd\" + \"ef\"; len(s)", 6},
+		{"let a = " + piece + "; let s = a + \"-\" + a + \"-\" + a; len(s)", 212},
+		{"let a = " + piece + "; let s = a + \"-\" + a; let m = {\"-\": 1}; m[s[70]]", 1},
+		// the parts keep their text when they change later and the other way round
+		{"let a = " + piece + "; let s = a + a; push(a, \"y\"); len(s) * 1000 + len(a)", 140071},
+		{"let a = " + piece + "; let s = a + a; pop(a); len(s) * 1000 + len(a)", 140069},
+		{"let a = " + piece + "; let s = a + a; push(s, \"y\"); len(s) * 1000 + len(a)", 141070},
+		{"let m = {}; let a = " + piece + "; m[a + a] = 1; m[a + a] + len(m)", 2},
+		{"let s = \"\"; let i = 0; while (i < 100000) { s = s + \"abcdefgh\"; i = i + 1; } let m = {\"h\": len(s)}; m[s[799999]]", 800000},
+	};
+
+	for (auto test : tests)
+	{
+		testIntegerObject(testEval(test.first), test.second);
+		testIntegerObject(testEval(test.first, true), test.second);
+	}
+
+	String *a = new String(std::string(40, 'a'));
+	String *b = new String(std::string(40, 'b'));
+	String *ab = new String(a, b);
+
+	a->append("c");
+	b->popBack();
+
+	if (ab->value() != std::string(40, 'a') + std::string(40, 'b') || ab->length() != 80)
+		std::cout << "wrong concatenation, got=" << ab->value() << std::endl;
+
+	if (a->length() != 41 || b->value() != std::string(39, 'b'))
+		std::cout << "wrong parts, got=" << a->value() << " " << b->value() << std::endl;
+
+	// a chain of + copies nothing until the result is read
+	Object *result;
+	timeEval("concatenating, 20000 pieces", appendingProgram(20000, "s = s + \"abcdefgh\";"), nullptr, &result);
+	testIntegerObject(result, 20000 * 8);
+
+	timeEval("concatenating, 80000 pieces", appendingProgram(80000, "s = s + \"abcdefgh\";"), nullptr, &result);
+	testIntegerObject(result, 80000 * 8);
+}
+
+void TestSlices()
+{
+	std::string text = "\"" + std::string(50, 'a') + std::string(50, 'b') + "\"";
+
+	std::vector<std::pair<std::string, int>> tests = {
+		{"let s = \"hello, world\"; len(s[0:5]) * 100 + len(s[7:]) * 10 + len(s[:0])", 550},
+		{"let s = " + text + "; let v = s[40:90]; let w = v[5:45]; let m = {\"a\": 1, \"b\": 2}; m[w[4]] * 10 + m[w[5]]", 12},
+		{"let a = [1, 2, 3, 4, 5]; let b = a[1:4]; b[0] + b[1] + b[2] + len(b) * 100", 309},
+		{"let a = [1, 2, 3, 4, 5]; let b = a[1:][1:][1:]; b[0] * 10 + len(b)", 42},
+		// a slice and what it was taken from change separately
+		{"let a = [1, 2, 3]; let b = a[0:2]; b[0] = 10; a[0] = 5; push(a, 4); a[0] * 100 + b[0] * 10 + len(a) - len(b)", 602},
+		{"let a = [1, 2, 3]; let b = a[1:]; pop(a); push(b, 9); len(a) * 100 + len(b) * 10 + b[2]", 239},
+		{"let s = " + text + "; let v = s[10:90]; push(v, \"c\"); push(s, \"d\"); len(s) * 1000 + len(v)", 101081},
+		{"let s = " + text + "; let v = s[10:90]; pop(s); let m = {\"b\": 1}; m[v[79]] + len(v)", 81},
+		// slices are keys by their text
+		{"let s = " + text + "; let m = {}; m[s[0:70]] = 1; m[s[:70]] = 2; m[s[0:70]] * 10 + len(m)", 21},
+		{"let f = def(a) { let s = 0; let i = 0; while (i < len(a)) { s = s + a[i]; i = i + 1; } s }; let a = [1, 2, 3, 4, 5, 6]; f(a[2:5]) + f(a[2:5])", 24},
+	};
+
+	for (auto test : tests)
+	{
+		testIntegerObject(testEval(test.first), test.second);
+		testIntegerObject(testEval(test.first, true), test.second);
+	}
+
+	std::vector<std::pair<std::string, std::string>> errors = {
+		{"\"abc\"[2:1]", "error: slice 2:1 out of range"},
+		{"[1, 2][0:3]", "error: slice 0:3 out of range"},
+		{"[1, 2][-1:]", "error: slice -1:2 out of range"},
+		{"{1: 2}[0:1]", "error: slice not supported for -> HASHMAP[INTEGER:INTEGER]"},
+		{"\"abc\"[\"a\":]", "error: slice not supported for -> STRING[STRING:]"},
+	};
+
+	for (auto test : errors)
+	{
+		std::string got = testEval(test.first)->inspect();
+		std::cout << got << std::endl;
+
+		if (got != test.second)
+			std::cout << "wrong error, got=" << got << " want=" << test.second << std::endl;
+	}
+
+	std::vector<std::pair<std::string, std::string>> printed = {
+		{"a[1:n - 1]", "a[1:(n-1)];"},
+		{"a[:2]", "a[0:2];"},
+		{"a[i:]", "a[i:];"},
+	};
+
+	for (auto test : printed)
+	{
+		std::string got = parse(test.first)->statements[0]->getStringRepr();
+
+		if (got != test.second)
+			std::cout << "wrong slice, got=" << got << " want=" << test.second << std::endl;
+	}
+
+	// slices share what they were taken from, slicing a large string or array
+	// costs as much as slicing a small one; the times are printed to compare
+	std::vector<std::pair<int, std::string>> kinds = {{0, "array"}, {1, "string"}};
+
+	for (auto kind : kinds)
+	{
+		int sizes[2] = {100, 1000000};
+
+		for (int s = 0; s < 2; s++)
+		{
+			Object *c;
+
+			if (kind.first == 0)
+			{
+				std::vector<Object *> elements(sizes[s], __NULL);
+				c = new Array(elements);
+			}
+			else
+				c = new String(std::string(sizes[s], 'x'));
+
+			Environment *env = new Environment();
+			env->Set("c", c);
+
+			// n wraps around for the large ones like the int arithmetic does
+			Object *result;
+			timeEval(kind.second + " slicing, size " + std::to_string(sizes[s]),
+					 "let i = 0; let n = 0; while (i < 20000) { n = n + len(c[1:len(c) - 1]); i = i + 1; } n", env, &result);
+			testIntegerObject(result, (int)(20000u * (unsigned)(sizes[s] - 2)));
+		}
+	}
+}
+
+void TestPackedArrays()
+{
+	std::vector<std::pair<std::string, int>> tests = {
+		{"let a = [5, -3, 9, 1, 7, 2, 8, 0, 4]; sum(a) * 10000 + (min(a) + 10) * 100 + max(a)", 330709},
+		{"let a = [5, -3, 9, 1, 7, 2, 8, 0, 4]; find(a, 7) * 100 + find(a, 4) * 10 - find(a, 42) - find(a, \"x\")", 482},
+		{"let a = [1, 2, 3, 4, 5, 6, 7]; let b = mul(add(a, 1), sub(a, [0, 0, 0, 0, 0, 0, 1])); b[0] * 100 + b[6]", 248},
+		{"sum([]) + len(add([], 2))", 0},
+		{"let a = [2147483647, 1]; sum(a) / 65536", -32768},
+		{"let a = [65536, 3, -5, 7, 65536]; let b = mul(a, a); b[0] + b[2] * 10 + b[3]", 299},
+		// storing anything but an integer boxes the values, which are then found the same
+		{"let a = [1, 2, 3, 4, 5]; a[0] = \"s\"; find(a, 4) * 10 + find(a, \"s\") + len(a) * 100", 530},
+		{"let a = [1, 2, 3]; push(a, \"s\"); a[3] = 4; sum(a) + max(add(a, a))", 18},
+		// slices of packed arrays
+		{"let a = [9, 1, 7, 2, 8, 3]; let b = a[1:5]; a[1] = 0; sum(b) * 100 + min(b) * 10 + find(b, 8)", 1813},
+		{"let a = [9, 1, 7, 2, 8, 3]; let b = a[2:]; b[0] = \"x\"; sum(a) * 10 + len(b)", 304},
+		// elements read before a change read back changed
+		{"let a = add([1, 2, 3], 0); let x = a[1]; a[1] = 7; push(a, 4); pop(a); x * 100 + a[1] * 10 + a[2]", 273},
+		{"let a = add([1, 2, 3], 0); a[0]; a[2] = \"s\"; a[0] + a[1]", 3},
+	};
+
+	for (auto test : tests)
+	{
+		testIntegerObject(testEval(test.first), test.second);
+		testIntegerObject(testEval(test.first, true), test.second);
+	}
+
+	std::vector<std::pair<std::string, std::string>> errors = {
+		{"min([])", "error: min of empty array"},
+		{"sum(3)", "error: expected ARRAY got INTEGER"},
+		{"sum([1, \"a\"])", "error: sum expects an array of INTEGER"},
+		{"add([1, 2], [1])", "error: add of arrays of length 2 and 1"},
+		{"mul([1, 2], \"a\")", "error: expected ARRAY got STRING"},
+	};
+
+	for (auto test : errors)
+	{
+		std::string got = testEval(test.first)->inspect();
+		std::cout << got << std::endl;
+
+		if (got != test.second)
+			std::cout << "wrong error, got=" << got << " want=" << test.second << std::endl;
+	}
+
+	std::vector<Object *> ints = {new Integer(1), new Integer(2)};
+	std::vector<Object *> mixed = {new Integer(1), __NULL};
+
+	if (!(new Array(ints))->isPacked() || (new Array(mixed))->isPacked())
+		std::cout << "wrong packing of arrays" << std::endl;
+
+	// indexing reads the same Integer each time, like an unpacked array
+	std::vector<int> small = {4, 5};
+	Array *packed = new Array(small);
+	Array *unpacked = new Array(mixed);
+
+	for (size_t i = 0; i < packed->size(); i++)
+		if (packed->at(i) != packed->at(i) || unpacked->at(i) != unpacked->at(i))
+			std::cout << "indexing allocated element " << i << " again" << std::endl;
+
+	if ((new Array(ints))->at(1) != ints[1])
+		std::cout << "indexing did not read the literal's Integer" << std::endl;
+
+	// summing the packed values 20 times against a loop summing them once, the
+	// times are printed to compare
+	std::vector<int> values(200000, 3);
+	Array *a = new Array(values);
+
+	Environment *env = new Environment();
+	env->Set("a", a);
+
+	Object *result;
+	timeEval("summing with sum()", "let i = 0; let n = 0; while (i < 20) { n = n + sum(a); i = i + 1; } n", env, &result);
+	testIntegerObject(result, 20 * 600000);
+
+	timeEval("summing in a loop", "let i = 0; let n = 0; while (i < len(a)) { n = n + a[i]; i = i + 1; } n", env, &result);
+	testIntegerObject(result, 600000);
+}
+
+Program *parse(std::string input)
+{
+	Lexer lexer;
+	lexer.New(input);
+
+	Parser parser;
+	parser.New(lexer);
+
+	return parser.ParseProgram();
+}
+
+// Seconds evaluating input takes, in env or a new environment. Prints the
+// time under label, and the result if it is an error.
+double timeEval(std::string label, std::string input, Environment *env, Object **result)
+{
+	Program *program = parse(input);
+	Evaluator evaluator;
+
+	if (env == nullptr)
+		env = new Environment();
+
+	auto start = std::chrono::steady_clock::now();
+	Object *obj = evaluator.Eval(program, env);
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::cout << label << ": " << elapsed.count() << "s" << std::endl;
+
+	if (obj->isError())
+		std::cout << obj->inspect() << std::endl;
+
+	if (result != nullptr)
+		*result = obj;
+
+	return elapsed.count();
+}
+
+Object *testEval(std::string input, bool resolve)
 {
 	Lexer lexer;
 	lexer.New(input);
@@ -41,6 +977,12 @@ Object *testEval(std::string input)
 	Evaluator evaluator;
 	Environment *env = new Environment();
 
+	if (resolve)
+	{
+		Resolver resolver;
+		resolver.Resolve(program, env);
+	}
+
 	Object *obj = evaluator.Eval(program, env);
 	return obj;
 }
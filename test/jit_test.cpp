@@ -0,0 +1,258 @@
+#include <iostream>
+#include <sstream>
+
+#include "../header/lexer.hpp"
+#include "../header/parser.hpp"
+#include "../header/evaluator.hpp"
+#include "../header/environment.hpp"
+#include "../header/jit.hpp"
+#include "../header/optimizer.hpp"
+
+struct JitTest
+{
+	std::string input;
+	std::string jittedFn; // function expected to end up with native code, empty if none
+};
+
+struct OsrTest
+{
+	std::string input;
+	bool jitted; // top level loop expected to end up with native code
+};
+
+void TestJitMatchesEvaluator();
+void TestOsrMatchesEvaluator();
+void TestInlinedCalls();
+std::string runProgram(std::string input, bool jit, Environment *env, Program **parsed = nullptr, int osrThreshold = 0, bool optimize = false);
+
+int main()
+{
+	if (!Jit::Supported())
+	{
+		std::cout << "jit: not supported on this platform, skipping" << std::endl;
+		return 0;
+	}
+
+	TestJitMatchesEvaluator();
+	TestOsrMatchesEvaluator();
+	TestInlinedCalls();
+}
+
+void TestJitMatchesEvaluator()
+{
+	std::vector<JitTest> tests = {
+		{"let fib = def(n) { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); }; fib(20)", "fib"},
+		{"let add = def(a, b) { a + b }; let i = 0; let s = 0; while (i < 50) { s = add(s, i); i = i + 1; } s", "add"},
+		{"let sumTo = def(n) { let i = 0; let s = 0; while (i <= n) { s = s + i * i % 7 - i / 3; i = i + 1; } return s; }; "
+		 "let i = 0; let r = 0; while (i < 20) { r = sumTo(i * 10); i = i + 1; } r",
+		 "sumTo"},
+		{"let isEven = def(n) { if (n == 0) { return true; } if (n == 1) { return false; } return isEven(n - 2); }; "
+		 "let i = 0; while (i < 10) { print(isEven(i), !isEven(i)); i = i + 1; }",
+		 "isEven"},
+		{"let sum = def(arr) { let i = 0; let s = 0; while (i < len(arr)) { s = s + arr[i]; i = i + 1; } s }; "
+		 "let a = [1, 2, 3, 4, 5, 6, 7, 8, 9, 10]; let i = 0; while (i < 10) { print(sum(a)); i = i + 1; }",
+		 "sum"},
+		{"let nested = def(n) { let i = 0; let c = 0; while (i < n) { let j = 0; while (j < n) { if (i != j) { c = c + 1; } j = j + 1; } i = i + 1; } c }; "
+		 "nested(3); nested(4); nested(5); nested(30)",
+		 "nested"},
+		{"let sum = def(arr) { let i = 0; let s = 0; while (i < len(arr)) { s = s + arr[i]; i = i + 1; } s }; "
+		 "let a = [1, 2, 3, 4, 5, 6, 7, 8, 9, 10]; print(sum(a[2:5]), sum(a[:3]), sum(a[9:]), sum(a[4:4]), sum(a[1:][1:]))",
+		 "sum"},
+		{"let sum = def(arr) { let i = 0; let s = 0; while (i < len(arr)) { s = s + arr[i]; i = i + 1; } s }; "
+		 "let a = [1, 2, 3, 4]; let b = [1, \"x\", 3]; b[1] = 2; print(sum(a), sum(a), sum(b), sum(a), sum(b[1:]), sum(add(a, 5)))",
+		 "sum"},
+		{"let tri = def(n) { let i = 0; let s = 0; while (i < n) { s += i; s -= 1; s *= 1; i += 1; } s }; tri(5); tri(10); tri(1000)", "tri"},
+		{"let gcd = def(x, y) { if (y == 0) { return x; } return gcd(y, x % y); }; gcd(27, 3); gcd(1071, 462); gcd(-48, 18)", "gcd"},
+		{"let f = def(n) { -n / -1 + (n % -1) * 3 }; f(1); f(0); f(-7)", "f"},
+		{"let count = def(n, acc) { if (n == 0) { return acc; } return count(n - 1, acc + 1); }; count(1, 0); count(2, 0); count(200000, 0)", "count"},
+		{"let total = def(arr, i, acc) { if (i == len(arr)) { acc } else { total(arr, i + 1, acc + arr[i]) } }; let a = [4, 5, 6]; total(a, 0, 0); total(a, 1, 0); total(a, 0, 100)", "total"},
+
+		// bailouts: the interpreter re-runs the call and reports what it always did
+		{"let div = def(a, b) { a / b }; div(10, 2); div(9, 3); print(div(1, 0)); div(8, 4)", "div"},
+		{"let at = def(arr, i) { arr[i] }; let a = [1, \"two\", 3]; at(a, 0); at(a, 2); print(at(a, 1)); print(at(a, 5)); at(a, 0)", "at"},
+		{"let last = def(n) { if (n > 0) { return n; } }; last(1); last(2); last(0)", "last"},
+		{"let down = def(n) { if (n == 0) { return 0; } return 1 + down(n - 1); }; down(10); down(10); down(1000)", "down"},
+
+		// guards: argument types and the binding recursive calls go through
+		{"let id = def(x) { x }; id(1); id(2); id(\"str\")", "id"},
+		{"let f = def(n) { if (n == 0) { return 0; } return f(n - 1) + 1; }; f(3); f(3); let g = f; f = def(n) { 100 }; g(5)", "g"},
+
+		// outside the subset, never compiled
+		{"let greet = def(s) { s + \"!\" }; greet(\"a\"); greet(\"b\"); greet(\"c\")", ""},
+		{"let p = def(n) { print(n); n }; p(1); p(2); p(3)", ""},
+	};
+
+	int failures = 0;
+
+	for (auto test : tests)
+	{
+		Environment *jitEnv = new Environment();
+
+		std::string expected = runProgram(test.input, false, new Environment());
+		std::string got = runProgram(test.input, true, jitEnv);
+
+		if (expected != got)
+		{
+			failures++;
+			std::cout << "jit mismatch for: " << test.input << std::endl
+					  << "  evaluator: " << expected << std::endl
+					  << "  jit      : " << got << std::endl;
+		}
+
+		if (!test.jittedFn.empty())
+		{
+			Object *fn = jitEnv->Get(test.jittedFn);
+
+			if (fn->type() != FUNCTION_OBJ || ((Function *)fn)->body->jitted == nullptr)
+			{
+				failures++;
+				std::cout << "jit did not compile " << test.jittedFn << " in: " << test.input << std::endl;
+			}
+		}
+	}
+
+	std::cout << "jit: " << tests.size() - failures << "/" << tests.size() << " programs match" << std::endl;
+}
+
+void TestOsrMatchesEvaluator()
+{
+	std::vector<OsrTest> tests = {
+		{"let i = 0; let s = 0; while (i < 100000) { s = s + i % 13; i = i + 1; } s", true},
+		{"let i = 0; let c = 0; while (i < 300) { let j = 0; while (j < 300) { if ((i + j) % 3 == 0) { c = c + 1; } j = j + 1; } i = i + 1; } c", true},
+		{"let a = [3, 1, 4, 1, 5, 9, 2, 6]; let i = 0; let m = 0; while (i < 8000) { if (a[i % len(a)] > m) { m = a[i % len(a)]; } i = i + 1; } m", true},
+		{"let i = 0; let even = true; while (i < 51) { even = !even; i = i + 1; } even", true},
+		{"let i = 0; let s = 0; while (i < 100000) { s += i % 13; i += 1; } s", true},
+		{"let f = def(n) { let i = 0; let s = 0; while (i < n) { s = s + i; i = i + 1; } s }; f(5000)", false},
+
+		// bailouts: the committed values go back to env and the closure tier finishes the loop
+		{"let i = 0; let s = 0; while (i < 100) { s = s + 100 / (50 - i); i = i + 1; } s", true},
+		{"let a = [1, 2, 3, \"x\", 5]; let i = 0; let s = 0; while (i < 5) { s = s + i; if (i == 3) { print(a[i]); } i = i + 1; } s", false},
+		{"let a = [1, 2, 3]; let i = 0; let s = 0; while (i < 40) { if (i < 3) { s = s + a[i]; } else { s = s + a[i - 3]; } i = i + 1; } s", true},
+
+		// outside the subset, run by the closure tier
+		{"let i = 0; let s = \"\"; while (i < 20) { s = s + \"a\"; i = i + 1; } s", false},
+		{"let i = 0; while (i < 10) { print(i); i = i + 1; }", false},
+		{"let f = def() { let i = 0; while (true) { if (i == 50) { return i; } i = i + 1; } }; f()", false},
+	};
+
+	int failures = 0;
+
+	for (auto test : tests)
+	{
+		Program *program;
+		std::string expected = runProgram(test.input, false, new Environment());
+		std::string got = runProgram(test.input, true, new Environment(), &program, 5);
+
+		if (expected != got)
+		{
+			failures++;
+			std::cout << "osr mismatch for: " << test.input << std::endl
+					  << "  evaluator: " << expected << std::endl
+					  << "  osr      : " << got << std::endl;
+		}
+
+		if (test.jitted)
+		{
+			WhileExpression *loop = nullptr;
+
+			for (auto stmt : program->statements)
+				if (stmt->nodeType() == "ExpressionStatement" &&
+					((ExpressionStatement *)stmt)->expression->nodeType() == "WhileExpression")
+					loop = (WhileExpression *)((ExpressionStatement *)stmt)->expression;
+
+			if (loop == nullptr || loop->jitted == nullptr)
+			{
+				failures++;
+				std::cout << "osr did not compile the loop in: " << test.input << std::endl;
+			}
+		}
+	}
+
+	std::cout << "osr: " << tests.size() - failures << "/" << tests.size() << " programs match" << std::endl;
+}
+
+// Calls the Optimizer inlined are compiled into the caller, and left to the
+// interpreter again once the name refers to something else
+void TestInlinedCalls()
+{
+	std::string sq = "let sq = def(x) { x * x }; ";
+	std::string f = "let f = def(n) { let i = 0; let s = 0; while (i < n) { s = s + sq(i); i = i + 1; } s }; ";
+	int failures = 0;
+
+	Environment *env = new Environment();
+	std::string expected = runProgram(sq + f + "print(f(10), f(20)); f(100)", false, new Environment());
+	std::string got = runProgram(sq + f + "print(f(10), f(20)); f(100)", true, env, nullptr, 0, true);
+
+	if (expected != got)
+	{
+		failures++;
+		std::cout << "inlined call mismatch, evaluator: " << expected << " jit: " << got << std::endl;
+	}
+
+	Object *fn = env->Get("f");
+
+	if (fn->type() != FUNCTION_OBJ || ((Function *)fn)->body->jitted == nullptr)
+	{
+		failures++;
+		std::cout << "jit did not compile f with an inlined call" << std::endl;
+	}
+
+	got = runProgram("sq = def(x) { 0 - x }; f(10)", true, env);
+
+	if (got != "-45")
+	{
+		failures++;
+		std::cout << "inlined call after rebinding, got=" << got << " want=-45" << std::endl;
+	}
+
+	Program *program;
+	std::string loop = sq + "let i = 0; let s = 0; while (i < 1000) { s = s + sq(i) % 7; i = i + 1; } s";
+
+	expected = runProgram(loop, false, new Environment());
+	got = runProgram(loop, true, new Environment(), &program, 5, true);
+
+	ExpressionStatement *stmt = (ExpressionStatement *)program->statements[3];
+
+	if (expected != got || ((WhileExpression *)stmt->expression)->jitted == nullptr)
+	{
+		failures++;
+		std::cout << "osr did not compile the loop with an inlined call, got=" << got << " want=" << expected << std::endl;
+	}
+
+	std::cout << "inlined calls: " << (failures == 0 ? "ok" : "failed") << std::endl;
+}
+
+std::string runProgram(std::string input, bool jit, Environment *env, Program **parsed, int osrThreshold, bool optimize)
+{
+	Lexer lexer;
+	lexer.New(input);
+
+	Parser parser;
+	parser.New(lexer);
+
+	Program *program = parser.ParseProgram();
+	if (parsed != nullptr)
+		*parsed = program;
+
+	if (optimize)
+	{
+		Optimizer optimizer;
+		optimizer.Optimize(program);
+	}
+
+	Evaluator evaluator;
+	if (jit)
+		evaluator.EnableJit(new Jit(2));
+	if (osrThreshold > 0)
+		evaluator.EnableOsr(osrThreshold);
+
+	// capture whatever the builtins print alongside the final value
+	std::stringstream out;
+	std::streambuf *old = std::cout.rdbuf(out.rdbuf());
+
+	Object *obj = evaluator.Eval(program, env);
+
+	std::cout.rdbuf(old);
+
+	return out.str() + obj->inspect();
+}
@@ -38,7 +38,9 @@ void testNextToken()
 		"\"foo bar\" "
 
 		"[1, 2]; "
-		"{\"foo\": \"bar\"} ";
+		"{\"foo\": \"bar\"} "
+
+		"x += 1; x -= 2; x *= 3; ";
 
 	std::vector<std::pair<TokenType, std::string>> tests;
 	tests.reserve(100);
@@ -130,6 +132,18 @@ void testNextToken()
 		{COLON, ":"},
 		{STRING, "bar"},
 		{RBRACE, "}"},
+		{IDENT, "x"},
+		{PLUS_ASSIGN, "+="},
+		{INTEGER, "1"},
+		{SEMICOLON, ";"},
+		{IDENT, "x"},
+		{MINUS_ASSIGN, "-="},
+		{INTEGER, "2"},
+		{SEMICOLON, ";"},
+		{IDENT, "x"},
+		{ASTERISK_ASSIGN, "*="},
+		{INTEGER, "3"},
+		{SEMICOLON, ";"},
 		{END, ""}};
 
 	Lexer lexer;
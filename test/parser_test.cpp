@@ -10,6 +10,8 @@ void TestLetStatement();
 void TestReturnStatement();
 void TestIdentifierExpression();
 void TestIntegerLiteralExpression();
+void TestCompoundAssignStatement();
+void TestCompoundAssignIndexError();
 
 int main()
 {
@@ -17,6 +19,8 @@ int main()
 	TestReturnStatement();
 	TestIdentifierExpression();
 	TestIntegerLiteralExpression();
+	TestCompoundAssignStatement();
+	TestCompoundAssignIndexError();
 }
 
 void checkParserErrors(Parser &parser)
@@ -223,4 +227,75 @@ void TestIntegerLiteralExpression()
 			std::cout << "intLit->value not '5'"
 					  << ", got " << stmt->tokenLiteral() << std::endl;
 	}
-}
\ No newline at end of file
+}
+
+void TestCompoundAssignStatement()
+{
+	std::string input =
+		"x += 1;"
+		"y -= z;"
+		"w *= 2 + 3;";
+
+	std::vector<std::string> expected{"x = (x+1);", "y = (y-z);", "w = (w*(2+3));"};
+	std::vector<std::string> ops{"+", "-", "*"};
+
+	Lexer lexer;
+	lexer.New(input);
+
+	Parser parser;
+	parser.New(lexer);
+
+	Program *program = parser.ParseProgram();
+
+	checkParserErrors(parser);
+
+	if (program->statements.size() != 3)
+	{
+		std::cout << "program->statements does not contain 3 statements, got " << program->statements.size() << std::endl;
+		return;
+	}
+
+	for (size_t i = 0; i < program->statements.size(); i++)
+	{
+		if (program->statements[i]->nodeType() != "AssignStatement")
+		{
+			std::cout << "stmt not AssignStatement, got " << program->statements[i]->nodeType() << std::endl;
+			continue;
+		}
+
+		AssignStatement *stmt = (AssignStatement *)program->statements[i];
+		std::string desugared = stmt->name.getStringRepr() + " = " + stmt->value->getStringRepr() + ";";
+
+		if (stmt->op != ops[i])
+			std::cout << "stmt->op not '" << ops[i] << "', got " << stmt->op << std::endl;
+
+		if (desugared != expected[i])
+			std::cout << "stmt->value not '" << expected[i] << "', got " << desugared << std::endl;
+	}
+}
+
+void TestCompoundAssignIndexError()
+{
+	std::vector<std::string> inputs{"m[k] += 1;", "a[i] *= 2; x = 1;", "a[0][1] -= f(2);"};
+
+	for (std::string input : inputs)
+	{
+		Lexer lexer;
+		lexer.New(input);
+
+		Parser parser;
+		parser.New(lexer);
+
+		parser.ParseProgram();
+
+		std::vector<std::string> errors = parser.Errors();
+
+		if (errors.size() != 1 || errors[0].find("cannot assign to an indexed expression") == std::string::npos)
+		{
+			std::cout << "expected one error for indexed compound assignment in '" << input << "', got " << errors.size() << std::endl;
+
+			for (std::string error : errors)
+				std::cout << "parser error : " << error << std::endl;
+		}
+	}
+}